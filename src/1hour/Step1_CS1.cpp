@@ -1,61 +1,16 @@
 #include "SGSimulation.hpp"
-
-/**
- * @brief Make a map from files
- * 
- * @param[in] filename File to make map from
- * @return Hour data <{timestamp, usage}, ...>
- */
-std::map<std::string, std::vector<double>> ReadData(const std::string& filename) {
-
-    // Read power consumption as map
-
-    std::ifstream readData(filename);
-    std::map<std::string, std::vector<double>> hourData;
-    std::string usage, line, time;
-    std::vector<double> usageHour;
-
-    bool flag = true;
-    // Each row as a new stringstream
-    while (getline(readData, line)) {
-        std::stringstream ss(line);
-        // Divide as two part: a string and a new stringstream
-        while (getline(ss, usage, ',')) {
-            if (flag) {
-                time = usage;
-                flag = false;
-            } else {
-                // Convert data to double, then push into usage vector
-                usageHour.push_back(std::stod(usage));
-            }
-        }
-        // Here if you don't need the first row which is the meter's number
-        if (time != "TimeSlot") {
-            hourData.insert(
-                std::pair<std::string, std::vector<double>>
-                {time, usageHour}
-            );
-        } else {
-        // If we need the first row which is the meter's number, uncomment this line
-        //hourData.insert(std::pair<std::string, std::vector<double>>{time, usageHour});
-        }
-        usageHour.clear();
-        flag = true;
-    }
-    return hourData;
-
-}
+#include "ConsumptionData.hpp"
 
 /**
  * @brief Harmonic mean for an hour
  * 
- * @param[in] vec Results vector
+ * @param[in] vec Readings of the hour, one per meter
+ * @param[in] n Number of meters
  * @return The harmonic mean for the hour of data
  */
-double HarmonicMean(std::vector<double> vec) {
+double HarmonicMean(const double* vec, int64_t n) {
 
     double sum = 0.0;
-    int64_t n = vec.size();
     for (int64_t i = 0; i < n; ++i) {
         sum += 1 / std::log(vec[i] + 2); // Scale 100 times
     }
@@ -66,14 +21,14 @@ double HarmonicMean(std::vector<double> vec) {
 /**
  * @brief Arithmetic mean for an hour
  * 
- * @param[in] vec Results vector
+ * @param[in] vec Readings of the hour, one per meter
+ * @param[in] n Number of meters
  * @return The arithmetic mean for the hour of data 
  */
-double ArithmeticMean(std::vector<double> vec) {
+double ArithmeticMean(const double* vec, int64_t n) {
 
     double sum = 0.0;
-    int64_t n = vec.size();
-    for (int64_t i = 0; i < vec.size(); ++i) {
+    for (int64_t i = 0; i < n; ++i) {
         sum += std::log(vec[i] + 2); // Scale x times
     }
     return sum / n;
@@ -113,8 +68,8 @@ int main(int argc, char** argv) {
     std::string resultDir(argv[3]);         // s3
     std::string hourNumber(argv[4]);        // s4
 
-    auto mapTimeData = ReadData(input);
-    std::cout << "Number of time slot is " << mapTimeData.size() << std::endl;
+    ConsumptionMatrix day = ReadConsumption(input);
+    std::cout << "Number of time slot is " << day.hours << std::endl;
     auto endRead = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> diffRead = endRead - startRead;
     std::cout << "1 Hour read data runtime is: " << diffRead.count() << "s" << std::endl;
@@ -154,25 +109,25 @@ int main(int argc, char** argv) {
 
     double sumAMTime = 0.0, sumHMTime = 0.0;
     double timeAM, timeHM;
-    std::cout << "Number of time slot is " << mapTimeData.size() << std::endl;
+    std::cout << "Number of time slot is " << day.hours << std::endl;
 
-    for (auto iter = mapTimeData.begin(); iter != mapTimeData.end(); ++iter) {
+    for (int64_t hour = 0; hour < day.hours; hour++) {
         auto startSum = std::chrono::high_resolution_clock::now();
-        std::cout << iter->first << std::endl;
-        std::cout << "Number of data is " << (iter->second).size() << std::endl;
+        std::cout << day.times[hour] << std::endl;
+        std::cout << "Number of data is " << day.meters << std::endl;
 
         seal::Ciphertext logSum, logRecSum;
-        std::vector<double> x = iter->second;
+        const double* x = day.Hour(hour);
         int64_t checkSumLog = 0, checkSumRecLog = 0;
         double maxNum = 0;
 
         std::cout << "\033[31m===Sum Usage Processing===\033[0m" << std::endl;
 
-        for (auto iterTwo = x.begin(); iterTwo != x.end(); ++iterTwo) {
-            int64_t temp = PRECISION * std::log(*iterTwo + 2);
-            double tep = PRECISION * std::log(*iterTwo + 2);
-            int64_t tempRec = PRECISION2 * 1 / log(*iterTwo + 2);
-            double tepRec = PRECISION2 * 1 / log(*iterTwo + 2);
+        for (int64_t meter = 0; meter < day.meters; meter++) {
+            int64_t temp = PRECISION * std::log(x[meter] + 2);
+            double tep = PRECISION * std::log(x[meter] + 2);
+            int64_t tempRec = PRECISION2 * 1 / log(x[meter] + 2);
+            double tepRec = PRECISION2 * 1 / log(x[meter] + 2);
 
             if (abs(tep - temp) >= 0.5) {
                 temp++;
@@ -184,8 +139,8 @@ int main(int argc, char** argv) {
             checkSumLog += temp;
             checkSumRecLog += tempRec;
             
-            if (*iterTwo >= maxNum) {
-                maxNum = *iterTwo;
+            if (x[meter] >= maxNum) {
+                maxNum = x[meter];
             }
 
             std::vector<int64_t> vecLog;
@@ -207,7 +162,7 @@ int main(int argc, char** argv) {
             seal::Ciphertext logEnc;
             encryptor.encrypt(polyLog, logEnc);
             
-            if (iterTwo == x.begin()) {
+            if (meter == 0) {
                 logSum = logEnc;
             } else {
                 evaluator.add_inplace(logSum, logEnc);
@@ -218,7 +173,7 @@ int main(int argc, char** argv) {
             seal::Ciphertext recLogEnc;
             encryptor.encrypt(polyRecLog, recLogEnc);
 
-            if (iterTwo == x.begin()) {
+            if (meter == 0) {
                 logRecSum = recLogEnc;
             } else {
                 evaluator.add_inplace(logRecSum, recLogEnc);
@@ -233,8 +188,8 @@ int main(int argc, char** argv) {
         std::cout << "Sum log() is: " << checkSumLog << ", Sum 1/log() is: " << checkSumRecLog << std::endl;
         std::cout << "Max usage is: " << maxNum << std::endl;
 
-        timeAM = ArithmeticMean(x);
-        timeHM = HarmonicMean(x);
+        timeAM = ArithmeticMean(x, day.meters);
+        timeHM = HarmonicMean(x, day.meters);
         std::cout << "Plaintext result >> AM:" << timeAM << ", HM:" << timeHM << std::endl;
 
         // Reset all values and increment timeslot
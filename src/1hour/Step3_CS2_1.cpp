@@ -90,11 +90,7 @@ int main(int argc, char** argv) {
 
     // Total Sum
 
-    for (int64_t i = 0; i < std::log2(rowSize); i++) {
-        seal::Ciphertext ct = sumResumtAMR;
-        evaluator.rotate_rows_inplace(ct, -std::pow(2, i), galoisKey);
-        evaluator.add_inplace(sumResumtAMR, ct);
-    }
+    TotalSum(evaluator, sumResumtAMR, rowSize, galoisKey);
     seal::Ciphertext AMRec;
 
     // If iter is 0, now we save
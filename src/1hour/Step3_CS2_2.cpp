@@ -96,11 +96,7 @@ int main(int argc, char** argv) {
     }
     sumResultHMR = sumResultH;
 
-    for (int64_t i = 0; i < std::log2(rowSize); i++) {
-        seal::Ciphertext ct = sumResultHMR;
-        evaluator.rotate_rows_inplace(ct, -std::pow(2, i), galoisKey);
-        evaluator.add_inplace(sumResultHMR, ct);
-    }
+    TotalSum(evaluator, sumResultHMR, rowSize, galoisKey);
 
     seal::Ciphertext HMRec;
 
@@ -97,27 +97,11 @@ int main(int argc, char** argv) {
     }
     std::cout << "Size after relinearization: " << AMRec1.size() << std::endl;
 
-    std::vector<seal::Ciphertext> z1(rowSize), z2(rowSize);
-    
-    std::fill(z1.begin(), z1.end(), AMRec1);
-    std::fill(z2.begin(), z2.end(), AMRec2);
-
     seal::Ciphertext CTAM1 = AMRec1; // AMRec1: sum all row
     seal::Ciphertext CTAM2 = AMRec2; // AMRec2: sum all row
 
     omp_set_num_threads(NF);
-    #pragma omp parallel for
-    for (int64_t i = 1; i < rowSize; i++) {
-        evaluator.rotate_rows_inplace(z1[i], i, galoisKey);
-        evaluator.relinearize_inplace(z1[i], relinKey);
-        evaluator.rotate_rows_inplace(z2[i], i, galoisKey);
-        evaluator.relinearize_inplace(z2[i], relinKey);
-    }
-
-    for (int64_t i = 1; i < rowSize; i++) {
-        evaluator.add_inplace(CTAM1, z1[i]);
-        evaluator.add_inplace(CTAM2, z2[i]);
-    }
+    TotalSum(evaluator, {&CTAM1, &CTAM2}, rowSize, galoisKey);
 
     std::ofstream resultAM;
     resultAM.open(resultDirName + "/AM1AM2_" + date, std::ios::binary);
@@ -97,27 +97,11 @@ int main(int argc, char** argv) {
     }
     std::cout << "Size after relinearization: " << HMRec1.size() << std::endl;
 
-    std::vector<seal::Ciphertext> z1(rowSize), z2(rowSize);
-    
-    std::fill(z1.begin(), z1.end(), HMRec1);
-    std::fill(z2.begin(), z2.end(), HMRec2);
-
     seal::Ciphertext CTHM1 = HMRec1; // HMRec1: sum all row
     seal::Ciphertext CTHM2 = HMRec2; // HMRec2: sum all row
 
     omp_set_num_threads(NF);
-    #pragma omp parallel for
-    for (int64_t i = 1; i < rowSize; i++) {
-        evaluator.rotate_rows_inplace(z1[i], i, galoisKey);
-        evaluator.relinearize_inplace(z1[i], relinKey);
-        evaluator.rotate_rows_inplace(z2[i], i, galoisKey);
-        evaluator.relinearize_inplace(z2[i], relinKey);
-    }
-
-    for (int64_t i = 1; i < rowSize; i++) {
-        evaluator.add_inplace(CTHM1, z1[i]);
-        evaluator.add_inplace(CTHM2, z2[i]);
-    }
+    TotalSum(evaluator, {&CTHM1, &CTHM2}, rowSize, galoisKey);
 
     std::ofstream resultHM;
     resultHM.open(resultDirName + "/HM1HM2_" + date, std::ios::binary);
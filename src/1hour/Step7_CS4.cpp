@@ -88,12 +88,7 @@ int main(int argc, char** argv) {
     auto startTotalSum = std::chrono::high_resolution_clock::now();
 
     seal::Ciphertext fin_res = sum_result_a;
-    for (int64_t i = 0; i < log2(row_size); i++) {
-        seal::Ciphertext t = fin_res;
-        evaluator.rotate_rows_inplace(t, -pow(2, i), galoisKey);
-        evaluator.relinearize_inplace(t, relinKey);
-        evaluator.add_inplace(fin_res, t);
-    }
+    TotalSum(evaluator, fin_res, row_size, galoisKey);
 
     auto endTotalSum = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> diffTotalSum = endTotalSum - startTotalSum;
@@ -273,4 +273,43 @@ seal::SEALContext CreateContextFromParams(std::string filepath, seal::scheme_typ
 
 }
 
+/**
+ * @brief Rotate-and-sum over each batch row: afterwards every slot of a row
+ * holds the row total. Takes log2(rowSize) rotations and keeps one extra
+ * ciphertext alive, instead of rowSize - 1 rotations held at once.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in,out] ct Ciphertext to sum
+ * @param[in] rowSize Slots in one batch row (a power of two)
+ * @param[in] galoisKey GaloisKeys with the power-of-two steps
+ */
+void TotalSum(seal::Evaluator& evaluator, seal::Ciphertext& ct, size_t rowSize, const seal::GaloisKeys& galoisKey) {
+
+    seal::Ciphertext rotated;
+    for (size_t step = 1; step < rowSize; step *= 2) {
+        evaluator.rotate_rows(ct, -(int)step, galoisKey, rotated);
+        evaluator.add_inplace(ct, rotated);
+    }
+
+}
+
+/**
+ * @brief TotalSum of independent ciphertexts, one per loop iteration, with
+ * the current OpenMP thread count and runtime schedule. Extra memory is one
+ * ciphertext per thread.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in,out] cts Ciphertexts to sum
+ * @param[in] rowSize Slots in one batch row (a power of two)
+ * @param[in] galoisKey GaloisKeys with the power-of-two steps
+ */
+void TotalSum(seal::Evaluator& evaluator, const std::vector<seal::Ciphertext*>& cts, size_t rowSize, const seal::GaloisKeys& galoisKey) {
+
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t i = 0; i < (int64_t)cts.size(); i++) {
+        TotalSum(evaluator, *cts[i], rowSize, galoisKey);
+    }
+
+}
+
 #endif // SMART_UTILITY_HPP
\ No newline at end of file
@@ -0,0 +1,293 @@
+/**
+ * @file ArtifactIO.hpp
+ * @brief Per-artifact compression and level of saved ciphertexts, with byte counts
+**/
+
+#ifndef SMART_ARTIFACTIO_HPP
+#define SMART_ARTIFACTIO_HPP
+
+#include "SGSimulation.hpp"
+#include "ZeroPool.hpp"
+
+/**
+ * @brief Process-wide save settings.
+ *
+ * Command line: --compr [artifact=]none|zlib|zstd,..., --no-mod-switch,
+ * --verify, --public-queries and --compare-queries. SG_COMPR,
+ * SG_MOD_SWITCH=0, SG_VERIFY=1, SG_PUBLIC_QUERIES=1 and SG_COMPARE_QUERIES=1
+ * are used when the flag is absent. Artifacts are named after their files:
+ * "AM", "HM", "pir_AMHM", "inv_SUM_AM", "div_HM", "pir_SUM_AM_DIV_HM",
+ * "Fin_AM1HM1", "inv_100", "pir_inv" and "finalRes".
+ */
+struct ArtifactConfig {
+
+    seal::compr_mode_type defaultCompr = seal::Serialization::compr_mode_default;
+    std::map<std::string, seal::compr_mode_type> artifactCompr;
+    std::atomic<bool> modSwitch{true};
+    bool verifyBudget = false; // TA checks every decrypted row, not one per artifact
+    bool seededQueries = true;
+    bool compareQueries = false;
+
+};
+
+/**
+ * @brief Returns the process-wide save settings.
+ *
+ * @return Save settings
+ */
+ArtifactConfig& Artifacts() {
+
+    static ArtifactConfig config;
+    return config;
+
+}
+
+/**
+ * @brief Parses a compression mode name.
+ *
+ * @param[in] name "none", "zlib" or "zstd"
+ * @return Compression mode
+ */
+seal::compr_mode_type ParseCompression(const std::string& name) {
+
+    if (name == "none") {
+        return seal::compr_mode_type::none;
+    }
+    if (name == "zlib") {
+        return seal::compr_mode_type::zlib;
+    }
+    if (name == "zstd") {
+        return seal::compr_mode_type::zstd;
+    }
+    throw std::invalid_argument("Unknown compression: " + name);
+
+}
+
+/**
+ * @brief Reads the save settings from the command line and environment.
+ * Call once at startup.
+ *
+ * @param[in] args Command line arguments
+ */
+void ConfigureArtifacts(const std::vector<std::string>& args) {
+
+    ArtifactConfig& config = Artifacts();
+    const char* compr = std::getenv("SG_COMPR");
+    const char* modSwitch = std::getenv("SG_MOD_SWITCH");
+    const char* verify = std::getenv("SG_VERIFY");
+    const char* publicQueries = std::getenv("SG_PUBLIC_QUERIES");
+    const char* compareQueries = std::getenv("SG_COMPARE_QUERIES");
+
+    std::stringstream modes(GetOption(args, "--compr", compr ? compr : ""));
+    std::string entry;
+    while (std::getline(modes, entry, ',')) {
+        size_t equals = entry.find('=');
+        if (equals == std::string::npos) {
+            config.defaultCompr = ParseCompression(entry);
+        } else {
+            config.artifactCompr[entry.substr(0, equals)] = ParseCompression(entry.substr(equals + 1));
+        }
+    }
+    config.modSwitch = !(HasFlag(args, "--no-mod-switch") || (modSwitch && std::string(modSwitch) == "0"));
+    config.verifyBudget = HasFlag(args, "--verify") || (verify && std::string(verify) == "1");
+    config.seededQueries = !(HasFlag(args, "--public-queries") || (publicQueries && std::string(publicQueries) == "1"));
+    config.compareQueries = HasFlag(args, "--compare-queries") || (compareQueries && std::string(compareQueries) == "1");
+
+}
+
+/**
+ * @brief Saves the ciphertexts of one step with the configured compression
+ * and counts the bytes written per artifact.
+ *
+ * Ciphertexts that the TA only decrypts are switched to the last level
+ * first: decryption works at any level, and the file and the decryption
+ * keep a single coefficient modulus. The switch does not depend on which
+ * keys the saving process holds; the TA checks the noise budget of each
+ * artifact it decrypts (every row with --verify) and fails if it is
+ * exhausted. Pipeline then reruns the day without the switch.
+ *
+ * TA queries are encrypted with the SecretKey and saved seeded: the second
+ * polynomial is replaced by the seed it was sampled from, which roughly
+ * halves the file. --public-queries restores the public-key encryption,
+ * --compare-queries reports the public-key size and time next to it.
+ */
+class ArtifactWriter {
+
+public:
+
+    /**
+     * @param[in] context SEALContext of the session
+     * @param[in] evaluator Evaluator used for the modulus switch
+     */
+    ArtifactWriter(const seal::SEALContext& context, seal::Evaluator& evaluator)
+        : context(context), evaluator(evaluator) {}
+
+    /**
+     * @brief Appends ct to out.
+     *
+     * @param[in] ct Ciphertext
+     * @param[in] out Artifact file
+     * @param[in] artifact Artifact name, selects the compression
+     * @param[in] decryptOnly The reader only decrypts ct, so it may be mod-switched
+     * @return Bytes written
+     */
+    int64_t operator()(const seal::Ciphertext& ct, std::ostream& out, const std::string& artifact, bool decryptOnly = false) {
+
+        if (decryptOnly && Switches(ct)) {
+            seal::Ciphertext low = ct;
+            SwitchForDecryption(low, artifact);
+            return Write(low, out, artifact);
+        }
+        return Write(ct, out, artifact);
+
+    }
+
+    /**
+     * @brief Switches a ciphertext the reader only decrypts to the last
+     * level, as operator() does with decryptOnly. Lets parallel workers do
+     * the switch so that a writer thread only streams the result.
+     *
+     * @param[in,out] ct Ciphertext
+     * @param[in] artifact Artifact name for the report
+     */
+    void SwitchForDecryption(seal::Ciphertext& ct, const std::string& artifact) {
+
+        if (!Switches(ct)) {
+            return;
+        }
+        int64_t full = ct.save_size(seal::compr_mode_type::none);
+        evaluator.mod_switch_to_inplace(ct, context.last_parms_id());
+        int64_t low = ct.save_size(seal::compr_mode_type::none);
+        std::lock_guard<std::mutex> lock(writtenMutex);
+        fullLevel[artifact] += full;
+        lastLevel[artifact] += low;
+
+    }
+
+    /**
+     * @brief Encrypts a PIR query and appends it to out. The encryptor needs
+     * the SecretKey unless --public-queries is set.
+     *
+     * With --compare-queries the first query is also encrypted with the
+     * PublicKey once, so the report can compare both encryptions.
+     *
+     * @param[in] encryptor Encryptor of the TA session
+     * @param[in] query Encoded query
+     * @param[in] out Query file
+     * @param[in] artifact Artifact name, selects the compression
+     * @param[in] zeroPool Precomputed zeros for the public-key encryption, if any
+     * @return Bytes written
+     */
+    int64_t Query(const seal::Encryptor& encryptor, const seal::Plaintext& query, std::ostream& out, const std::string& artifact, ZeroPool* zeroPool = nullptr) {
+
+        seal::compr_mode_type compr = Compression(artifact);
+        bool seeded = Artifacts().seededQueries;
+
+        if (seeded && Artifacts().compareQueries && publicBytes == 0) {
+            auto startPublic = std::chrono::high_resolution_clock::now();
+            seal::Ciphertext reference;
+            encryptor.encrypt(query, reference);
+            std::chrono::duration<double> diffPublic = std::chrono::high_resolution_clock::now() - startPublic;
+            publicSeconds = diffPublic.count();
+            publicBytes = reference.save_size(compr);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        int64_t bytes;
+        if (seeded) {
+            bytes = encryptor.encrypt_symmetric(query).save(out, compr);
+        } else {
+            seal::Ciphertext ct;
+            if (zeroPool) {
+                zeroPool->Encrypt(query, ct);
+            } else {
+                encryptor.encrypt(query, ct);
+            }
+            bytes = ct.save(out, compr);
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+
+        std::lock_guard<std::mutex> lock(writtenMutex);
+        written[artifact] += bytes;
+        queries++;
+        querySeconds += diff.count();
+        queryBytes += bytes;
+        return bytes;
+
+    }
+
+    /**
+     * @brief Prints the bytes written per artifact.
+     *
+     * @param[in] step Step name for the report
+     */
+    void Report(const std::string& step) {
+
+        std::lock_guard<std::mutex> lock(writtenMutex);
+        int64_t total = 0;
+        for (const auto& entry : written) {
+            std::cout << step << " wrote " << entry.first << ": " << entry.second << " bytes" << std::endl;
+            total += entry.second;
+        }
+        std::cout << step << " wrote " << total << " bytes in total" << std::endl;
+
+        for (const auto& entry : fullLevel) {
+            int64_t low = lastLevel[entry.first];
+            std::cout << step << " " << entry.first << " at the last level: " << low << " bytes uncompressed instead of "
+                << entry.second << " (" << 100.0 * low / entry.second << "%)" << std::endl;
+        }
+
+        if (queries > 0) {
+            bool seeded = Artifacts().seededQueries;
+            std::cout << step << " queries: " << queries << (seeded ? " seeded" : " public-key")
+                << ", " << queryBytes << " bytes, " << querySeconds << "s encrypt+save" << std::endl;
+            if (seeded && publicBytes > 0) {
+                // Extrapolated from the reference encryption, which is
+                // timed without its save
+                std::cout << step << " public-key estimate: " << publicBytes * queries << " bytes, "
+                    << publicSeconds * queries << "s encrypt" << std::endl;
+            }
+        }
+
+    }
+
+private:
+
+    bool Switches(const seal::Ciphertext& ct) const {
+
+        return Artifacts().modSwitch && ct.parms_id() != context.last_parms_id();
+
+    }
+
+    int64_t Write(const seal::Ciphertext& ct, std::ostream& out, const std::string& artifact) {
+
+        int64_t bytes = ct.save(out, Compression(artifact));
+        std::lock_guard<std::mutex> lock(writtenMutex);
+        written[artifact] += bytes;
+        return bytes;
+
+    }
+
+    seal::compr_mode_type Compression(const std::string& artifact) const {
+
+        const ArtifactConfig& config = Artifacts();
+        auto found = config.artifactCompr.find(artifact);
+        return (found != config.artifactCompr.end()) ? found->second : config.defaultCompr;
+
+    }
+
+    seal::SEALContext context;
+    seal::Evaluator& evaluator;
+    std::mutex writtenMutex;
+    std::map<std::string, int64_t> written;
+    std::map<std::string, int64_t> fullLevel;
+    std::map<std::string, int64_t> lastLevel;
+    int64_t queries = 0;
+    int64_t queryBytes = 0;
+    double querySeconds = 0.0;
+    int64_t publicBytes = 0;
+    double publicSeconds = 0.0;
+
+};
+
+#endif // SMART_ARTIFACTIO_HPP
@@ -0,0 +1,331 @@
+/**
+ * @file ArtifactStore.hpp
+ * @brief Result artifacts (AM_i, pir_*, finalRes, ...) kept in files or in memory
+**/
+
+#ifndef SMART_ARTIFACTSTORE_HPP
+#define SMART_ARTIFACTSTORE_HPP
+
+#include "SGSimulation.hpp"
+
+/**
+ * @brief Where the steps keep their result artifacts.
+ *
+ * Files (default): every artifact is a file under the result directory, as
+ * the separate Step binaries and daemons need. Memory: artifacts stay in the
+ * process as serialized buffers keyed by their path, for the in-process
+ * Pipeline runner. With persist set, memory artifacts are also written out.
+ */
+class ArtifactStore {
+
+public:
+
+    /**
+     * @brief Keeps artifacts in memory from now on.
+     *
+     * @param[in] persist Also write every artifact to its file
+     */
+    void UseMemory(bool persist) {
+
+        std::lock_guard<std::mutex> lock(storeMutex);
+        memory = true;
+        this->persist = persist;
+
+    }
+
+    bool InMemory() const {
+
+        return memory;
+
+    }
+
+    bool Persist() const {
+
+        return persist;
+
+    }
+
+    /**
+     * @brief Stores the bytes of an artifact, replacing an older one.
+     *
+     * @param[in] path Artifact path
+     * @param[in] data Serialized artifact
+     */
+    void Put(const std::string& path, std::string&& data) {
+
+        std::lock_guard<std::mutex> lock(storeMutex);
+        artifacts[path] = std::make_shared<const std::string>(std::move(data));
+
+    }
+
+    /**
+     * @brief Bytes of an artifact held in memory.
+     *
+     * @param[in] path Artifact path
+     * @return Artifact, or nullptr when it is not in memory
+     */
+    std::shared_ptr<const std::string> Get(const std::string& path) {
+
+        std::lock_guard<std::mutex> lock(storeMutex);
+        auto found = artifacts.find(path);
+        return (found != artifacts.end()) ? found->second : nullptr;
+
+    }
+
+    /**
+     * @brief Deletes an artifact from memory and from disk.
+     *
+     * @param[in] path Artifact path
+     */
+    void Remove(const std::string& path) {
+
+        {
+            std::lock_guard<std::mutex> lock(storeMutex);
+            artifacts.erase(path);
+        }
+        std::remove(path.c_str());
+
+    }
+
+    /**
+     * @brief Drops every in-memory artifact under a directory.
+     *
+     * @param[in] dir Result directory
+     */
+    void Clear(const std::string& dir) {
+
+        std::lock_guard<std::mutex> lock(storeMutex);
+        std::string prefix = dir + "/";
+        for (auto it = artifacts.begin(); it != artifacts.end(); ) {
+            it = (it->first.compare(0, prefix.size(), prefix) == 0) ? artifacts.erase(it) : std::next(it);
+        }
+
+    }
+
+private:
+
+    std::mutex storeMutex;
+    std::map<std::string, std::shared_ptr<const std::string>> artifacts;
+    std::atomic<bool> memory{false};
+    std::atomic<bool> persist{false};
+
+};
+
+/**
+ * @brief Returns the process-wide artifact store.
+ *
+ * @return Artifact store
+ */
+ArtifactStore& Store() {
+
+    static ArtifactStore store;
+    return store;
+
+}
+
+/**
+ * @brief Stream buffer appending to a string.
+ */
+class StringWriteBuffer : public std::streambuf {
+
+public:
+
+    std::string data;
+
+protected:
+
+    int_type overflow(int_type c) override {
+
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            data.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+
+        data.append(s, n);
+        return n;
+
+    }
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+
+        // Only tellp() is supported
+        if (off != 0 || dir == std::ios_base::beg || !(which & std::ios_base::out)) {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(off_type(data.size()));
+
+    }
+
+};
+
+/**
+ * @brief Read-only stream buffer over a shared string.
+ */
+class StringReadBuffer : public std::streambuf {
+
+public:
+
+    explicit StringReadBuffer(std::shared_ptr<const std::string> data)
+        : data(std::move(data)) {
+
+        char* begin = const_cast<char*>(this->data->data());
+        setg(begin, begin, begin + this->data->size());
+
+    }
+
+protected:
+
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override {
+
+        char* base = (dir == std::ios_base::beg) ? eback() : (dir == std::ios_base::cur) ? gptr() : egptr();
+        char* target = base + off;
+        if (!(which & std::ios_base::in) || target < eback() || target > egptr()) {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), target, egptr());
+        return pos_type(off_type(target - eback()));
+
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+
+    }
+
+private:
+
+    std::shared_ptr<const std::string> data;
+
+};
+
+/**
+ * @brief Output stream of one artifact, used like std::ofstream. In memory
+ * mode the bytes reach the store on close().
+ */
+class ArtifactOutput : public std::ostream {
+
+public:
+
+    ArtifactOutput() : std::ostream(nullptr) {}
+
+    explicit ArtifactOutput(const std::string& path) : std::ostream(nullptr) {
+
+        open(path);
+
+    }
+
+    ~ArtifactOutput() {
+
+        close();
+
+    }
+
+    /**
+     * @param[in] path Artifact path
+     */
+    void open(const std::string& path) {
+
+        close();
+        this->path = path;
+        clear();
+        if (Store().InMemory()) {
+            memoryBuffer = std::make_unique<StringWriteBuffer>();
+            rdbuf(memoryBuffer.get());
+        } else if (fileBuffer.open(path, std::ios::out | std::ios::binary)) {
+            rdbuf(&fileBuffer);
+        } else {
+            setstate(std::ios::failbit);
+        }
+
+    }
+
+    void close() {
+
+        if (memoryBuffer) {
+            if (Store().Persist()) {
+                std::ofstream file(path, std::ios::binary);
+                file.write(memoryBuffer->data.data(), memoryBuffer->data.size());
+            }
+            Store().Put(path, std::move(memoryBuffer->data));
+            memoryBuffer.reset();
+        }
+        if (fileBuffer.is_open()) {
+            fileBuffer.close();
+        }
+        rdbuf(nullptr);
+
+    }
+
+private:
+
+    std::string path;
+    std::filebuf fileBuffer;
+    std::unique_ptr<StringWriteBuffer> memoryBuffer;
+
+};
+
+/**
+ * @brief Input stream of one artifact, used like std::ifstream. In memory
+ * mode the artifact is read from the store, or from its file when the store
+ * does not hold it.
+ */
+class ArtifactInput : public std::istream {
+
+public:
+
+    ArtifactInput() : std::istream(nullptr) {}
+
+    explicit ArtifactInput(const std::string& path) : std::istream(nullptr) {
+
+        open(path);
+
+    }
+
+    /**
+     * @param[in] path Artifact path
+     */
+    void open(const std::string& path) {
+
+        close();
+        clear();
+        std::shared_ptr<const std::string> data = Store().InMemory() ? Store().Get(path) : nullptr;
+        if (data) {
+            memoryBuffer = std::make_unique<StringReadBuffer>(data);
+            rdbuf(memoryBuffer.get());
+        } else if (fileBuffer.open(path, std::ios::in | std::ios::binary)) {
+            rdbuf(&fileBuffer);
+        } else {
+            setstate(std::ios::failbit);
+        }
+
+    }
+
+    bool is_open() const {
+
+        return memoryBuffer != nullptr || fileBuffer.is_open();
+
+    }
+
+    void close() {
+
+        memoryBuffer.reset();
+        if (fileBuffer.is_open()) {
+            fileBuffer.close();
+        }
+        rdbuf(nullptr);
+
+    }
+
+private:
+
+    std::filebuf fileBuffer;
+    std::unique_ptr<StringReadBuffer> memoryBuffer;
+
+};
+
+#endif // SMART_ARTIFACTSTORE_HPP
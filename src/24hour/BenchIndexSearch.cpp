@@ -0,0 +1,108 @@
+#include "IndexSearch.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Sign-change search on synthetic decoded LUT differences.
+// Usage: BenchIndexSearch [searches]
+// Builds AM-like (falling), HM-like (rising, exact zeros) and div_HM-like
+// (two rows) tables of 4096-slot rows the way Step1/Step3 produce them:
+// sum - table entry, padded entries, and a second batch row holding sum - 0.
+// Every kernel must return the scalar result.
+
+/**
+ * @brief Decoded differences of one function
+ *
+ * @param[in] entries Table entries
+ * @param[in] step Difference between neighbouring entries (sign gives the direction)
+ * @param[in] pad Padding entry after the table
+ * @param[in] rowSize Slots per batch row
+ * @param[in] rng Random engine
+ * @return Decoded rows, 2 * rowSize slots each
+ */
+std::vector<std::vector<int64_t>> MakeDifferences(int64_t entries, int64_t step, int64_t pad, int64_t rowSize, std::mt19937_64& rng) {
+
+    int64_t rows = (entries + rowSize - 1) / rowSize;
+    int64_t first = 100000;
+    std::uniform_int_distribution<int64_t> pick(0, entries - 1);
+    int64_t sum = first + pick(rng) * step;
+
+    std::vector<std::vector<int64_t>> decoded(rows, std::vector<int64_t>(2 * rowSize, sum));
+    for (int64_t s = 0; s < rows; s++) {
+        for (int64_t k = 0; k < rowSize; k++) {
+            int64_t e = s * rowSize + k;
+            decoded[s][k] = sum - ((e < entries) ? first + e * step : pad);
+        }
+    }
+    return decoded;
+
+}
+
+int main(int argc, char** argv) {
+
+    int64_t searches = (argc > 1) ? std::stoll(argv[1]) : 20000;
+    int64_t rowSize = 4096;
+    std::mt19937_64 rng(2014);
+
+    struct Case {
+        std::string name;
+        int64_t entries, step, pad;
+        Crossing direction;
+        bool zeroHit;
+    };
+    std::vector<Case> cases = {
+        {"AM", 2850, 1, 50000, Crossing::Falling, false},
+        {"HM", 2653, -1, 10000, Crossing::Rising, true},
+        {"div_HM", 7935, 1, 60000, Crossing::Falling, true},
+    };
+
+    std::vector<std::string> kernels = {"scalar"};
+#ifdef SMART_INDEXSEARCH_X86
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back("avx2");
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        kernels.push_back("avx512");
+    }
+#endif
+
+    std::cout << "Default kernel: " << SearchKernelName() << std::endl;
+    std::cout << "table,kernel,ns_per_search,speedup" << std::endl;
+
+    for (const Case& c : cases) {
+        // A pool of tables so the crossing moves between searches
+        std::vector<std::vector<std::vector<int64_t>>> tables;
+        for (int t = 0; t < 64; t++) {
+            tables.push_back(MakeDifferences(c.entries, c.step, c.pad, rowSize, rng));
+        }
+
+        std::vector<SlotIndex> expected;
+        for (const auto& table : tables) {
+            expected.push_back(FindCrossing(table, rowSize, c.direction, c.zeroHit, FindEventScalar));
+        }
+
+        double scalarNs = 0.0;
+        for (const std::string& name : kernels) {
+            FindEventFn kernel = SearchKernel(name);
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int64_t n = 0; n < searches; n++) {
+                const auto& table = tables[n % tables.size()];
+                SlotIndex index = FindCrossing(table, rowSize, c.direction, c.zeroHit, kernel);
+                const SlotIndex& want = expected[n % tables.size()];
+                if (index.row != want.row || index.col != want.col || index.found != want.found) {
+                    std::cout << "MISMATCH " << c.name << " " << name << std::endl;
+                    return 1;
+                }
+            }
+            std::chrono::duration<double, std::nano> diff = std::chrono::high_resolution_clock::now() - start;
+            double ns = diff.count() / searches;
+            if (name == "scalar") {
+                scalarNs = ns;
+            }
+            std::cout << c.name << "," << name << "," << ns << "," << scalarNs / ns << std::endl;
+        }
+    }
+
+    return 0;
+
+}
@@ -0,0 +1,179 @@
+#include "ConsumptionData.hpp"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+
+// Daily file ingestion: the old getline/stringstream/stod map against the
+// mapped from_chars matrix.
+// Usage: BenchIngest <dataDir>
+//        BenchIngest --synthetic [meters] [days]
+// With a data directory every *.txt file in it is read, e.g. a year of
+// DateWiseData/NormalWinso/2014. --synthetic writes <days> daily files
+// (default 365) of <meters> meters (default 150) to BenchIngestData first.
+// Both parsers must give the same hours and readings.
+
+/**
+ * @brief ReadData as Step1_CS1 used it before ConsumptionData.hpp
+ *
+ * @param[in] filename Path to data file
+ * @return Readings per TimeSlot label
+ */
+std::map<std::string, std::vector<double>> LegacyReadData(const std::string& filename) {
+
+    std::ifstream readData(filename);
+    std::map<std::string, std::vector<double>> hourData;
+    std::string usage_str, line_str, time_st;
+    std::vector<double> usage_hour;
+
+    bool flag = true;
+    while (std::getline(readData, line_str)) {
+        std::stringstream ss(line_str);
+        while (std::getline(ss, usage_str, ',')) {
+            if (flag) {
+                time_st = usage_str;
+                flag = false;
+            } else {
+                usage_hour.push_back(std::stod(usage_str));
+            }
+        }
+        if (time_st != "TimeSlot") {
+            hourData.insert(std::pair<std::string, std::vector<double>>(time_st, usage_hour));
+        }
+        usage_hour.clear();
+        flag = true;
+    }
+    return hourData;
+
+}
+
+/**
+ * @brief Writes daily files in the DateWiseData layout
+ *
+ * @param[in] dir Output directory
+ * @param[in] meters Meters per file
+ * @param[in] days Number of files
+ * @return Paths of the files
+ */
+std::vector<std::string> WriteSynthetic(const std::string& dir, int64_t meters, int64_t days) {
+
+    mkdir(dir.c_str(), 0755);
+    std::mt19937_64 rng(2014);
+    std::gamma_distribution<double> usage(1.5, 0.4);
+
+    std::vector<std::string> files;
+    for (int64_t d = 0; d < days; d++) {
+        std::ostringstream name;
+        name << dir << "/day" << std::setw(3) << std::setfill('0') << d << ".txt";
+        std::ofstream out(name.str());
+        out << "TimeSlot";
+        for (int64_t m = 0; m < meters; m++) {
+            out << "," << m + 1;
+        }
+        out << "\n" << std::setprecision(6);
+        for (int hour = 0; hour < 24; hour++) {
+            out << "2014-" << d << " " << std::setw(2) << std::setfill('0') << hour << ":00:00";
+            for (int64_t m = 0; m < meters; m++) {
+                out << "," << usage(rng);
+            }
+            out << "\n";
+        }
+        files.push_back(name.str());
+    }
+    return files;
+
+}
+
+int main(int argc, char** argv) {
+
+    if (argc < 2) {
+        std::cout << "Usage: BenchIngest <dataDir> | --synthetic [meters] [days]" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> files;
+    if (std::string(argv[1]) == "--synthetic") {
+        int64_t meters = (argc > 2) ? std::stoll(argv[2]) : 150;
+        int64_t days = (argc > 3) ? std::stoll(argv[3]) : 365;
+        files = WriteSynthetic("BenchIngestData", meters, days);
+    } else {
+        files = DailyFiles(argv[1]);
+    }
+    if (files.empty()) {
+        std::cout << "No daily files found" << std::endl;
+        return 1;
+    }
+
+    int64_t bytes = 0;
+    for (const std::string& file : files) {
+        struct stat info;
+        if (stat(file.c_str(), &info) == 0) {
+            bytes += info.st_size;
+        }
+    }
+
+    // Warm the page cache so both parsers read from memory
+    for (const std::string& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        std::ostringstream sink;
+        sink << in.rdbuf();
+    }
+
+    double checksumLegacy = 0.0, checksumMatrix = 0.0;
+    int64_t readings = 0;
+
+    auto startLegacy = std::chrono::high_resolution_clock::now();
+    for (const std::string& file : files) {
+        std::map<std::string, std::vector<double>> hours = LegacyReadData(file);
+        for (auto iter = hours.begin(); iter != hours.end(); ++iter) {
+            std::vector<double> x = iter->second;
+            for (double reading : x) {
+                checksumLegacy += reading;
+            }
+        }
+    }
+    std::chrono::duration<double> diffLegacy = std::chrono::high_resolution_clock::now() - startLegacy;
+
+    auto startMatrix = std::chrono::high_resolution_clock::now();
+    for (const std::string& file : files) {
+        ConsumptionMatrix day = ReadConsumption(file);
+        for (int64_t hour = 0; hour < day.hours; hour++) {
+            const double* x = day.Hour(hour);
+            for (int64_t m = 0; m < day.meters; m++) {
+                checksumMatrix += x[m];
+            }
+        }
+        readings += day.hours * day.meters;
+    }
+    std::chrono::duration<double> diffMatrix = std::chrono::high_resolution_clock::now() - startMatrix;
+
+    // Same hours, labels and readings, file by file
+    int64_t mismatches = 0;
+    for (const std::string& file : files) {
+        std::map<std::string, std::vector<double>> hours = LegacyReadData(file);
+        ConsumptionMatrix day = ReadConsumption(file);
+        bool same = (int64_t)hours.size() == day.hours;
+        int64_t hour = 0;
+        for (auto iter = hours.begin(); same && iter != hours.end(); ++iter, ++hour) {
+            same = iter->first == day.times[hour] && (int64_t)iter->second.size() == day.meters
+                && std::equal(iter->second.begin(), iter->second.end(), day.Hour(hour));
+        }
+        if (!same) {
+            std::cout << "Mismatch in " << file << std::endl;
+            mismatches++;
+        }
+    }
+
+    double megabytes = bytes / 1e6;
+    std::cout << "Files: " << files.size() << ", " << megabytes << " MB, " << readings << " readings" << std::endl;
+    std::cout << "getline/stod map: " << diffLegacy.count() << "s, " << megabytes / diffLegacy.count() << " MB/s" << std::endl;
+    std::cout << "mmap/from_chars matrix: " << diffMatrix.count() << "s, " << megabytes / diffMatrix.count() << " MB/s" << std::endl;
+    std::cout << "Speedup: " << diffLegacy.count() / diffMatrix.count() << "x" << std::endl;
+    std::cout << "Checksums: " << checksumLegacy << " / " << checksumMatrix << ", mismatching files: " << mismatches << std::endl;
+
+    return mismatches == 0 ? 0 : 1;
+
+}
@@ -0,0 +1,97 @@
+#include "Quantize.hpp"
+#include <chrono>
+#include <iostream>
+#include <random>
+
+// Fixed-point log and 1/log quantization of synthetic hourly readings.
+// Usage: BenchQuantize [meters] [hours]
+// Readings follow a skewed kWh-like distribution plus exact rounding
+// boundaries of both scales, so the fallback path is exercised too. Every
+// kernel must match QuantizeReading bit for bit.
+
+/**
+ * @brief Readings x with PRECISION * log(x + 2) or PRECISION2 / log(x + 2)
+ * at k + 0.5, the worst case for a fast log
+ *
+ * @param[in] count Number of readings
+ * @param[in] rng Random engine
+ * @return Readings
+ */
+std::vector<double> BoundaryReadings(int64_t count, std::mt19937_64& rng) {
+
+    std::uniform_int_distribution<int64_t> pickLog(23, 200);
+    std::uniform_int_distribution<int64_t> pickRec(300, 1400);
+    std::vector<double> readings;
+    for (int64_t i = 0; i < count; i++) {
+        double x = (i % 2 == 0)
+            ? std::exp((pickLog(rng) + 0.5) / PRECISION) - 2
+            : std::exp(PRECISION2 / (pickRec(rng) + 0.5)) - 2;
+        if (x >= 0) {
+            readings.push_back(x);
+        }
+    }
+    return readings;
+
+}
+
+int main(int argc, char** argv) {
+
+    int64_t meters = (argc > 1) ? std::stoll(argv[1]) : 4096;
+    int64_t hours = (argc > 2) ? std::stoll(argv[2]) : 24 * 365;
+    std::mt19937_64 rng(2014);
+
+    std::gamma_distribution<double> usage(1.5, 0.4);
+    std::vector<double> readings(meters);
+    for (double& x : readings) {
+        x = usage(rng);
+    }
+    std::vector<double> boundary = BoundaryReadings(meters, rng);
+
+    std::vector<std::string> kernels = {"scalar"};
+#ifdef SMART_QUANTIZE_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        kernels.push_back("avx2");
+    }
+#endif
+
+    std::vector<int64_t> expectedLog, expectedRec;
+    QuantizeHour(readings.data(), meters, expectedLog, expectedRec, QuantizeScalar);
+    std::vector<int64_t> boundaryLog, boundaryRec;
+    QuantizeHour(boundary.data(), boundary.size(), boundaryLog, boundaryRec, QuantizeScalar);
+
+    std::cout << "Default kernel: " << QuantizeKernelName() << std::endl;
+    std::cout << "kernel,ns_per_reading,readings_per_s,speedup" << std::endl;
+
+    double scalarNs = 0.0;
+    for (const std::string& name : kernels) {
+        QuantizeFn kernel = QuantizeKernel(name);
+        std::vector<int64_t> logValues, recLogValues;
+
+        QuantizeHour(boundary.data(), boundary.size(), logValues, recLogValues, kernel);
+        if (logValues != boundaryLog || recLogValues != boundaryRec) {
+            std::cout << "MISMATCH on rounding boundaries " << name << std::endl;
+            return 1;
+        }
+
+        int64_t checksum = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int64_t h = 0; h < hours; h++) {
+            QuantizeHour(readings.data(), meters, logValues, recLogValues, kernel);
+            checksum += logValues[h % meters] + recLogValues[h % meters];
+        }
+        std::chrono::duration<double, std::nano> diff = std::chrono::high_resolution_clock::now() - start;
+        if (logValues != expectedLog || recLogValues != expectedRec || checksum == 0) {
+            std::cout << "MISMATCH " << name << std::endl;
+            return 1;
+        }
+
+        double ns = diff.count() / (meters * hours);
+        if (name == "scalar") {
+            scalarNs = ns;
+        }
+        std::cout << name << "," << ns << "," << 1e9 / ns << "," << scalarNs / ns << std::endl;
+    }
+
+    return 0;
+
+}
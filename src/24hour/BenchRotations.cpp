@@ -0,0 +1,71 @@
+#include "Session.hpp"
+#include "PIRQuery.hpp"
+
+// PIR row selection: per-row rotate loop against shared selectors.
+// Usage: BenchRotations [--rows N] [--meters N] [--threads N]
+// Uses the AM, HM, SUM_AM and div_HM row counts of the manifest, or N rows
+// for every table when --rows is given. SUM_AM and div_HM feed two output
+// tables each, so the per-row loop selects their rows twice as Step5 did.
+
+int main(int argc, char** argv) {
+
+    std::cout << "Setting FHE" << std::endl;
+
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    FHESession session(true, false, MeterCount(args));
+    auto& evaluator = session.evaluator;
+    auto& galoisKey = session.galoisKey;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+
+    const TableManifest& manifest = session.manifest;
+    int64_t forcedRows = std::stoll(GetOption(args, "--rows", "0"));
+
+    std::vector<std::tuple<std::string, int64_t, int64_t>> tables = {
+        {"AM", manifest.rowsAM, 1},
+        {"HM", manifest.rowsHM, 1},
+        {"SUM_AM", manifest.rowsAMInv, 2},
+        {"div_HM", manifest.rowsDivHM, 2},
+    };
+
+    std::vector<int64_t> vec(session.slotCount, 1);
+    seal::Plaintext poly;
+    session.batchEncoder.encode(vec, poly);
+    seal::Ciphertext query0, query1;
+    session.encryptor.encrypt(poly, query0);
+    session.encryptor.encrypt(poly, query1);
+
+    std::cout << "table,rows,outputs,per_row_seconds,shared_seconds,speedup" << std::endl;
+
+    for (const auto& table : tables) {
+        int64_t rows = forcedRows > 0 ? forcedRows : std::get<1>(table);
+        int64_t outputs = std::get<2>(table);
+
+        // Current loop: every output table rotates and multiplies the query again
+
+        std::vector<seal::Ciphertext> perRow(rows * outputs);
+        auto startPerRow = std::chrono::high_resolution_clock::now();
+        ParallelLoop("pir");
+        #pragma omp parallel for schedule(runtime)
+        for (int64_t k = 0; k < rows * outputs; k++) {
+            seal::Ciphertext temp = query1;
+            evaluator.rotate_rows_inplace(temp, -(k % rows), galoisKey);
+            evaluator.multiply_inplace(temp, query0);
+            relinearize(temp);
+            perRow[k] = temp;
+        }
+        std::chrono::duration<double> diffPerRow = std::chrono::high_resolution_clock::now() - startPerRow;
+
+        auto startShared = std::chrono::high_resolution_clock::now();
+        std::vector<seal::Ciphertext> shared = RowSelectors(evaluator, relinearize, query0, query1, rows, galoisKey);
+        std::chrono::duration<double> diffShared = std::chrono::high_resolution_clock::now() - startShared;
+
+        std::cout << std::get<0>(table) << "," << rows << "," << outputs << ","
+            << diffPerRow.count() << "," << diffShared.count() << ","
+            << diffPerRow.count() / diffShared.count() << std::endl;
+    }
+
+    ShowMemoryUsage(getpid());
+    return 0;
+
+}
@@ -0,0 +1,104 @@
+#include "Session.hpp"
+
+// Thread scaling of the LUT loops.
+// Usage: BenchThreads [--max-threads N] [--meters N] [--pin none|compact|spread]
+// Sweeps 1, 2, 4, ... threads for each schedule over the Step1 table
+// subtraction and the Step3 PIR rotate/multiply, 24 hours x table rows each.
+
+/**
+ * @brief Runs body(k) for k in [0, count) and returns the wall time
+ *
+ * @param[in] count Iteration count
+ * @param[in] body Loop body
+ * @return Runtime in seconds
+ */
+double TimeLoop(int64_t count, const std::function<void(int64_t)>& body) {
+
+    auto start = std::chrono::high_resolution_clock::now();
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t k = 0; k < count; k++) {
+        body(k);
+    }
+    std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+    return diff.count();
+
+}
+
+int main(int argc, char** argv) {
+
+    std::cout << "Setting FHE" << std::endl;
+
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    int maxThreads = std::stoi(GetOption(args, "--max-threads", std::to_string(omp_get_num_procs())));
+
+    FHESession session(true, false, MeterCount(args));
+    auto& evaluator = session.evaluator;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+    auto& galoisKey = session.galoisKey;
+
+    int64_t row_count_AM = session.manifest.rowsAM;
+    const CipherTable& AM_tab = session.Table("AM_input", row_count_AM);
+    const OutputTable& output_AM = session.Output("AM_output", row_count_AM);
+
+    // One encrypted sum and one query pair per hour
+
+    std::vector<seal::Ciphertext> sums(24), query0(24), query1(24);
+    for (int64_t i = 0; i < 24; i++) {
+        std::vector<int64_t> vec(session.slotCount, 0);
+        vec[i] = 1;
+        seal::Plaintext poly;
+        session.batchEncoder.encode(vec, poly);
+        session.encryptor.encrypt(poly, sums[i]);
+        session.encryptor.encrypt(poly, query0[i]);
+        session.encryptor.encrypt(poly, query1[i]);
+    }
+
+    int64_t count = 24 * row_count_AM;
+    std::vector<seal::Ciphertext> results(count);
+
+    auto lut = [&](int64_t k) {
+        seal::Ciphertext temp = sums[k / row_count_AM];
+        evaluator.sub_inplace(temp, AM_tab[k % row_count_AM]);
+        results[k] = temp;
+    };
+    auto pir = [&](int64_t k) {
+        int64_t j = k % row_count_AM;
+        seal::Ciphertext temp = query1[k / row_count_AM];
+        evaluator.rotate_rows_inplace(temp, -j, galoisKey);
+        evaluator.multiply_inplace(temp, query0[k / row_count_AM]);
+        relinearize(temp);
+        output_AM.MultiplyRow(evaluator, temp, j);
+        relinearize(temp);
+        results[k] = temp;
+    };
+
+    std::vector<std::string> schedules = {"static", "dynamic:1", "guided"};
+    std::vector<std::pair<std::string, std::function<void(int64_t)>>> loops = {{"lut", lut}, {"pir", pir}};
+
+    std::cout << "Iterations per loop: " << count << std::endl;
+    std::cout << "loop,schedule,threads,seconds,speedup" << std::endl;
+
+    for (const auto& loop : loops) {
+        for (const std::string& spec : schedules) {
+            LoopSchedule schedule = ParseSchedule(spec);
+            omp_set_schedule(schedule.kind, schedule.chunk);
+
+            double base = 0.0;
+            for (int threads = 1; threads <= maxThreads; threads *= 2) {
+                omp_set_num_threads(threads);
+                TimeLoop(count, loop.second); // warm up the team
+                double seconds = TimeLoop(count, loop.second);
+                if (threads == 1) {
+                    base = seconds;
+                }
+                std::cout << loop.first << "," << spec << "," << threads << ","
+                    << seconds << "," << base / seconds << std::endl;
+            }
+        }
+    }
+
+    ShowMemoryUsage(getpid());
+    return 0;
+
+}
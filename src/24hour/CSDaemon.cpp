@@ -0,0 +1,49 @@
+#include "CSSteps.hpp"
+#include "Daemon.hpp"
+
+int main(int argc, char** argv) {
+
+    // Keys and tables stay resident; each job only pays for its own work
+
+    std::string socketPath = (argc > 1 && argv[1][0] != '-') ? argv[1] : "cs.sock";
+
+    std::cout << "Setting FHE" << std::endl;
+
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    ConfigureArtifacts(args);
+    ConfigureZeroPool(args);
+    FHESession session(true, false, MeterCount(args));
+    const TableManifest& manifest = session.manifest;
+
+    std::cout << "Mapping tables" << std::endl;
+    session.Table("AM_input", manifest.rowsAM);
+    session.Table("HM_input", manifest.rowsHM);
+    session.Output("AM_output", manifest.rowsAM);
+    session.Output("HM_output", manifest.rowsHM);
+    session.Table("SUM_AM_input", manifest.rowsAMInv);
+    session.Table("div_HM_input", manifest.rowsDivHM);
+    session.Output("inv_SUM_AM_output1", manifest.rowsAMInv);
+    session.Output("inv_SUM_AM_output2", manifest.rowsAMInv);
+    session.Output("div_HM_output1", manifest.rowsDivHM);
+    session.Output("div_HM_output2", manifest.rowsDivHM);
+    session.Table("inv_100_input", manifest.rows100Inv);
+    session.Output("inv_100_output", manifest.rows100Inv);
+
+    return ServeJobs(socketPath, [&session](const std::vector<std::string>& args) {
+        if (args[0] == "Step1_CS1" && args.size() >= 4) {
+            return Step1CS1(session, args[1], args[2], args[3], HasFlag(args, "--packed"), GetOption(args, "--spool", ""), HasFlag(args, "--stream"), GetOption(args, "--archive", ""));
+        }
+        if (args[0] == "Step3_CS2" && args.size() >= 3) {
+            return Step3CS2(session, args[1], args[2], HasFlag(args, "--stream"));
+        }
+        if (args[0] == "Step5_CS3" && args.size() == 3) {
+            return Step5CS3(session, args[1], args[2]);
+        }
+        if (args[0] == "Step7_CS4" && args.size() == 3) {
+            return Step7CS4(session, args[1], args[2]);
+        }
+        throw std::invalid_argument("Unknown CS job: " + args[0]);
+    });
+
+}
@@ -0,0 +1,819 @@
+/**
+ * @file CSSteps.hpp
+ * @brief Computing server (CS) steps of the 24 hour pipeline
+**/
+
+#ifndef SMART_CS_STEPS_HPP
+#define SMART_CS_STEPS_HPP
+
+#include "Session.hpp"
+#include "PIRQuery.hpp"
+#include "HourQueue.hpp"
+#include "ConsumptionArchive.hpp"
+
+/**
+ * @brief Encrypts one day of readings and subtracts the AM/HM input tables.
+ *
+ * With packed set, every meter of an hour goes into its own slot so the hour
+ * costs two encryptions, and the per-meter sum is done by rotate-and-sum.
+ *
+ * With spoolDir set, the per-meter ciphertexts written by MeterFleet are
+ * aggregated instead of being encrypted here (ignored when packed).
+ *
+ * @param[in] session CS session (PublicKey, RelinKey, GaloisKey if packed)
+ * @param[in] inputFile Daily consumption file
+ * @param[in] resultFile Plaintext ratio file, appended to
+ * @param[in] resultDir Directory for AM_i and HM_i
+ * @param[in] packed Encrypt one slot-packed ciphertext per hour
+ * @param[in] spoolDir MeterFleet spool directory, empty to encrypt locally
+ * @param[in] stream Announce each finished hour in AMHM.ready for Step2_TA1
+ * @param[in] archiveFile Consumption archive holding the day of inputFile, empty to parse inputFile
+ * @return Exit status
+ */
+int Step1CS1(FHESession& session, const std::string& inputFile, const std::string& resultFile, const std::string& resultDir, bool packed = false, const std::string& spoolDir = "", bool stream = false, const std::string& archiveFile = "") {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& evaluator = session.evaluator;
+    auto& batchEncoder = session.batchEncoder;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+    ArtifactWriter save(session.context, session.evaluator);
+    auto& galoisKey = session.galoisKey;
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+    int64_t row_count_AM = session.manifest.rowsAM;
+    int64_t row_count_HM = session.manifest.rowsHM;
+
+    // Read table
+
+    const CipherTable& AM_tab = session.Table("AM_input", row_count_AM);
+    const CipherTable& HM_tab = session.Table("HM_input", row_count_HM);
+
+    // Read data
+
+    ConsumptionMatrix day = ReadDay(inputFile, archiveFile);
+    std::cout << "Number of time slot is " << day.hours << std::endl;
+
+    // Sum the usage of per day
+
+    int64_t timeslot;
+    std::vector<seal::Ciphertext> AM_sum_res, HM_sum_res;
+    for (timeslot = 0; timeslot < 24; timeslot++) {
+        seal::Ciphertext tts;
+        AM_sum_res.push_back(tts);
+        HM_sum_res.push_back(tts);
+    }
+
+    timeslot = 0;
+    double Sum_AM_time = 0.0, Sum_HM_time = 0.0;
+    double AM_time, HM_time;
+    for (int64_t hour = 0; hour < day.hours; hour++) {
+        std::cout << day.times[hour] << std::endl;
+        std::cout << "Number of data is " << day.meters << std::endl;
+
+        seal::Ciphertext log_sum, log_rec_sum;
+        const double* x = day.Hour(hour);
+        int64_t checksumlog = 0, checksumreclog = 0;
+        double max_num = 0;
+
+        // Packed mode: meter k goes to slot k of the first row, meters past
+        // row_size fold onto the same slots since only the total is needed
+        std::vector<int64_t> packed_log, packed_rec_log;
+        if (packed) {
+            packed_log.resize(slot_count, 0);
+            packed_rec_log.resize(slot_count, 0);
+        }
+
+        // Fixed-point log and 1/log of every meter of the hour in one pass
+        std::vector<int64_t> log_values, rec_log_values;
+        QuantizeHour(x, day.meters, log_values, rec_log_values);
+
+        std::cout << "===Sum Usage Processing===" << std::endl;
+        for (int64_t meter = 0; meter < day.meters; meter++) {
+            int64_t temp = log_values[meter], temp_rec = rec_log_values[meter];
+
+            checksumlog += temp;
+            checksumreclog += temp_rec;
+            if (x[meter] >= max_num) {
+                max_num = x[meter];
+            }
+
+            if (packed) {
+                size_t slot = meter % row_size;
+                packed_log[slot] += temp;
+                packed_rec_log[slot] += temp_rec;
+                continue;
+            }
+
+            seal::Ciphertext log_enc, rec_log_enc;
+            if (!spoolDir.empty()) {
+                // The meter already encrypted its own reading
+                std::ifstream meterFile(SpoolPath(spoolDir, timeslot, meter), std::ios::binary);
+                log_enc.load(context, meterFile);
+                rec_log_enc.load(context, meterFile);
+                meterFile.close();
+            } else {
+                std::vector<int64_t> vec_log;
+                for (int i = 0; i < row_size; i++) {
+                    vec_log.push_back(temp);
+                }
+                vec_log.resize(slot_count);
+
+                std::vector<int64_t> vec_rec_log;
+                for (int i = 0; i < row_size; i++) {
+                    vec_rec_log.push_back(temp_rec);
+                }
+                vec_rec_log.resize(slot_count);
+
+                // Encrypt the usage and the 1/usage
+
+                seal::Plaintext poly_log;
+                batchEncoder.encode(vec_log, poly_log);
+                session.Encrypt(poly_log, log_enc);
+
+                seal::Plaintext poly_rec_log;
+                batchEncoder.encode(vec_rec_log, poly_rec_log);
+                session.Encrypt(poly_rec_log, rec_log_enc);
+            }
+
+            // Add to log_sum and rec_log_sum
+
+            if (meter == 0) {
+                log_sum = log_enc;
+            } else {
+                evaluator.add_inplace(log_sum, log_enc);
+            }
+            if (meter == 0) {
+                log_rec_sum = rec_log_enc;
+            } else {
+                evaluator.add_inplace(log_rec_sum, rec_log_enc);
+            }
+            relinearize(log_rec_sum);
+
+        }
+
+        if (packed) {
+            seal::Plaintext poly_log, poly_rec_log;
+            batchEncoder.encode(packed_log, poly_log);
+            session.Encrypt(poly_log, log_sum);
+            batchEncoder.encode(packed_rec_log, poly_rec_log);
+            session.Encrypt(poly_rec_log, log_rec_sum);
+
+            // Rotate-and-sum leaves the hour total in every slot of the row,
+            // the same layout the per-meter encryption produces
+            ParallelLoop("sum");
+            TotalSum(evaluator, {&log_sum, &log_rec_sum}, row_size, galoisKey);
+        }
+
+        AM_sum_res[timeslot] = log_sum;
+        HM_sum_res[timeslot] = log_rec_sum;
+
+        std::cout << "CHECK TEST (INT)" << std::endl;
+        std::cout << "Sum log() is: " << checksumlog << ", Sum 1/log() is: " << checksumreclog << std::endl;
+        std::cout << "Max usage is: " << max_num << std::endl;
+        AM_time = ArithmeticMean(x, day.meters);
+        HM_time = HarmonicMean(x, day.meters);
+        std::cout << "Plaintext result >> AM: " << AM_time << ", HM: " << HM_time << std::endl;
+        checksumlog = 0, checksumreclog = 0;
+        max_num = 0.0;
+        timeslot++;
+        Sum_AM_time += AM_time;
+        Sum_HM_time += HM_time;
+        AM_time = 0.0, HM_time = 0.0;
+
+    }
+
+    double ratio = Sum_HM_time / Sum_AM_time;
+
+    std::cout << "Plaintext sum_AM: " << Sum_AM_time << ", sum_HM: " << Sum_HM_time << ", ratio result: " << ratio << std::endl;
+    std::ofstream pt_ratio; // date_ArithMean_hour
+    pt_ratio.open(resultFile, std::ios::app);
+    pt_ratio << ratio << std::endl;
+    pt_ratio.close();
+
+    std::cout << "===Sum Usage Processing End===" << std::endl;
+    auto endSum = std::chrono::high_resolution_clock::now();
+
+    std::cout << "===Table Search Processing===" << std::endl;
+
+    // All 24 x (AM + HM) subtractions form one task set so every thread has
+    // work even with one or two table rows. Each job also switches its result
+    // to the last level; the writer thread saves AM_i/HM_i in hour order as
+    // soon as every job of hour i is done.
+
+    int64_t jobs_per_hour = row_count_AM + row_count_HM;
+    std::vector<std::vector<seal::Ciphertext>> result_ct(24, std::vector<seal::Ciphertext>(jobs_per_hour));
+    std::vector<int64_t> pending(24, jobs_per_hour);
+    std::mutex hour_mutex;
+    std::condition_variable hour_done;
+    HourQueue ready(resultDir + "/AMHM.ready");
+
+    std::thread writer([&]() {
+        for (int64_t i = 0; i < 24; i++) {
+            {
+                std::unique_lock<std::mutex> lock(hour_mutex);
+                hour_done.wait(lock, [&]() { return pending[i] == 0; });
+            }
+
+            ArtifactOutput result_AM; // date_ArithMean_hour
+            result_AM.open(resultDir + "/AM_" + std::to_string(i));
+            for (int64_t j = 0; j < row_count_AM; j++) {
+                save(result_ct[i][j], result_AM, "AM", true);
+            }
+            result_AM.close();
+
+            ArtifactOutput result_HM;
+            result_HM.open(resultDir + "/HM_" + std::to_string(i));
+            for (int64_t j = row_count_AM; j < jobs_per_hour; j++) {
+                save(result_ct[i][j], result_HM, "HM", true);
+            }
+            result_HM.close();
+
+            result_ct[i].clear();
+            if (stream) {
+                ready.Publish(i);
+            }
+            std::cout << "TIME SLOT: " << i << std::endl;
+        }
+    });
+
+    ParallelLoop("lut");
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t k = 0; k < 24 * jobs_per_hour; k++) {
+        int64_t i = k / jobs_per_hour;
+        int64_t j = k % jobs_per_hour;
+
+        // Search sum of log or sum of 1/log
+        seal::Ciphertext temp;
+        if (j < row_count_AM) {
+            temp = AM_sum_res[i];
+            evaluator.sub_inplace(temp, AM_tab[j]);
+            relinearize(temp);
+        } else {
+            temp = HM_sum_res[i];
+            evaluator.sub_inplace(temp, HM_tab[j - row_count_AM]);
+        }
+        // The mod switch stays in the parallel loop; the writer only streams
+        save.SwitchForDecryption(temp, (j < row_count_AM) ? "AM" : "HM");
+        result_ct[i][j] = std::move(temp);
+
+        std::lock_guard<std::mutex> lock(hour_mutex);
+        if (--pending[i] == 0) {
+            hour_done.notify_one();
+        }
+    }
+    writer.join();
+
+    std::cout << "===Table Search Processing End===" << std::endl;
+
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diff1 = endSum - startWhole;
+    std::chrono::duration<double> diff2 = endWhole - endSum;
+
+    std::cout << "Runtime sum is: " << diff1.count() << "s" << std::endl;
+    std::cout << "Runetime LUT is: " << diff2.count() << "s" << std::endl;
+    relinearize.Report("Step1_CS1");
+    save.Report("Step1_CS1");
+    if (session.zeroPool) {
+        session.zeroPool->Report("Step1_CS1");
+    }
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Evaluates the 24 hourly AM/HM PIR queries and subtracts the
+ * SUM_AM/div_HM input tables from the daily sums. When Step2_TA1 wrote
+ * pir_AMHM_batch, all hours are evaluated from it in one pass.
+ *
+ * @param[in] session CS session (PublicKey, GaloisKey, RelinKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] resultDir Directory for pir_AMHM_i, inv_SUM_AM and div_HM
+ * @param[in] stream Evaluate each pir_AMHM_i as soon as pir.ready announces it
+ * @return Exit status
+ */
+int Step3CS2(FHESession& session, const std::string& date, const std::string& resultDir, bool stream = false) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& evaluator = session.evaluator;
+    auto& galoisKey = session.galoisKey;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << slot_count << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t row_count_AM = session.manifest.rowsAM;
+    int64_t row_count_HM = session.manifest.rowsHM;
+    int64_t sum_row_count_AM = session.manifest.rowsAMInv;
+    int64_t div_row_count_HM = session.manifest.rowsDivHM;
+
+    std::cout << "AM row " << row_count_AM << ", HM row " << row_count_HM << std::endl;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    // Read output table
+
+    const OutputTable& output_AM = session.Output("AM_output", row_count_AM);
+    const OutputTable& output_HM = session.Output("HM_output", row_count_HM);
+
+    std::vector<seal::Ciphertext> res_a, res_h, sum_result_a, sum_result_h;
+    // res_a: result of one time slot AM for each row
+    // sum_result_a: result of one time slot AM (sum all row)
+    // res_h: result of one time slot HM for each row
+    // sum_result_h: result of one time slot HM (sum all row)
+
+    for (int64_t i = 0; i < row_count_AM; i++) {
+        res_a.push_back(seal::Ciphertext());
+    }
+    for(int64_t i = 0; i < row_count_HM; i++) {
+        res_h.push_back(seal::Ciphertext());
+    }
+    for (int64_t i = 0; i < 24; i++) {
+        seal::Ciphertext temp;
+        sum_result_a.push_back(temp);
+        sum_result_h.push_back(temp);
+    }
+
+    ////////////////////////////////////////////////////////////////////
+
+    std::cout << "===Main===" << std::endl;
+
+    seal::Ciphertext AM_rec, HM_rec;
+    ArtifactInput batchQueryFile;
+    if (!stream) {
+        batchQueryFile.open(resultDir + "/pir_AMHM_batch");
+    }
+    HourQueue ready(resultDir + "/pir.ready");
+
+    if (batchQueryFile.is_open()) {
+        // Step2_TA1 --batch: query j holds, per slot, how many hours select
+        // that entry of table row j, AM in batch row 0 and HM in batch row 1.
+        // The selected outputs of all hours come out summed in one pass.
+        std::cout << "===Reading batched query from DS===" << std::endl;
+        int64_t batch_rows = std::max(row_count_AM, row_count_HM);
+        std::vector<seal::Ciphertext> ct_query(batch_rows);
+        for (int64_t j = 0; j < batch_rows; j++) {
+            ct_query[j].load(context, batchQueryFile);
+        }
+        batchQueryFile.close();
+
+        std::cout << "LUT Processing" << std::endl;
+
+        ParallelLoop("pir");
+        #pragma omp parallel for schedule(runtime)
+        for (int64_t k = 0; k < row_count_AM + row_count_HM; k++) {
+            if (k < row_count_AM) {
+                seal::Ciphertext temp = ct_query[k];
+                output_AM.MultiplyRow(evaluator, temp, k);
+                relinearize(temp);
+                res_a[k] = temp;
+            } else {
+                int64_t j = k - row_count_AM;
+                seal::Ciphertext temp = ct_query[j];
+                evaluator.rotate_columns_inplace(temp, galoisKey);
+                output_HM.MultiplyRow(evaluator, temp, j);
+                relinearize(temp);
+                res_h[j] = temp;
+            }
+        }
+
+        AM_rec = res_a[0];
+        for (int64_t k = 1; k < row_count_AM; k++) {
+            evaluator.add_inplace(AM_rec, res_a[k]);
+        }
+        HM_rec = res_h[0];
+        for (int64_t k = 1; k < row_count_HM; k++) {
+            evaluator.add_inplace(HM_rec, res_h[k]);
+        }
+    } else {
+        for (int64_t iter = 0; iter < 24; iter++) {
+            if (stream && ready.Next() != iter) {
+                std::cout << "pir.ready aborted or out of order at hour " << iter << std::endl;
+                return 1;
+            }
+
+            // Read index and PIR query from file
+            std::cout << "===Reading query from DS===" << std::endl;
+            ArtifactInput PIRqueryFile(resultDir + "/pir_AMHM_" + std::to_string(iter));
+            seal::Ciphertext ct_query_AM0, ct_query_AM1, ct_query_HM0, ct_query_HM1;
+            ct_query_AM0.load(context, PIRqueryFile);
+            ct_query_AM1.load(context, PIRqueryFile);
+            ct_query_HM0.load(context, PIRqueryFile);
+            ct_query_HM1.load(context, PIRqueryFile);
+            PIRqueryFile.close();
+
+            std::cout << "Reading query from DS > OK" << std::endl;
+            std::cout << "LUT Processing" << std::endl;
+
+            std::vector<seal::Ciphertext> select_AM = RowSelectors(evaluator, relinearize, ct_query_AM0, ct_query_AM1, row_count_AM, galoisKey);
+            std::vector<seal::Ciphertext> select_HM = RowSelectors(evaluator, relinearize, ct_query_HM0, ct_query_HM1, row_count_HM, galoisKey);
+
+            ParallelLoop("pir");
+            #pragma omp parallel for schedule(runtime)
+            for (int64_t j = 0; j < row_count_AM; j++) {
+                seal::Ciphertext temp = select_AM[j];
+                output_AM.MultiplyRow(evaluator, temp, j);
+                relinearize(temp);
+                res_a[j] = temp;
+            }
+
+            ParallelLoop("pir");
+            #pragma omp parallel for schedule(runtime)
+            for (int64_t k = 0; k < row_count_HM; k++) {
+                seal::Ciphertext temp = select_HM[k];
+                output_HM.MultiplyRow(evaluator, temp, k);
+                relinearize(temp);
+                res_h[k] = temp;
+            }
+
+            std::cout << "===Sum Result===" << std::endl;
+
+            sum_result_a[iter] = res_a[0];
+            for (int k = 1; k < row_count_AM; k++) {
+                evaluator.add_inplace(sum_result_a[iter], res_a[k]);
+            }
+
+            sum_result_h[iter] = res_h[0];
+            for (int i = 1; i < row_count_HM; i++) {
+                evaluator.add_inplace(sum_result_h[iter], res_h[i]);
+            }
+
+        }
+        if (stream) {
+            ready.Finish();
+        }
+
+        std::cout << "We have " << sum_result_a.size() << " AM." << std::endl;
+        std::cout << "We have " << sum_result_h.size() << " HM." << std::endl;
+        AM_rec = sum_result_a[0];
+        HM_rec = sum_result_h[0];
+
+        for (int64_t i = 1; i < 24; i++) {
+            std::cout << "Hour." << i << std::endl;
+            evaluator.add_inplace(AM_rec, sum_result_a[i]);
+            relinearize(AM_rec);
+            evaluator.add_inplace(HM_rec, sum_result_h[i]);
+            relinearize(HM_rec);
+        }
+    }
+
+    // TotalSum is linear, so summing the hours first needs one TotalSum per
+    // mean instead of one per hour
+
+    auto startTS = std::chrono::high_resolution_clock::now();
+    ParallelLoop("sum");
+    TotalSum(evaluator, {&AM_rec, &HM_rec}, row_size, galoisKey);
+    std::chrono::duration<double> diffTS = std::chrono::high_resolution_clock::now() - startTS;
+    std::cout << "TotalSum: " << diffTS.count() << "s" << std::endl;
+
+    // LUT sumAM => 1/sumAM
+
+    std::cout << "Read table for sum 1/AM" << std::endl;
+    const CipherTable& AM_tab = session.Table("SUM_AM_input", sum_row_count_AM);
+
+    // Read table
+
+    ArtifactOutput result_AM;
+    result_AM.open(resultDir + "/inv_SUM_AM_" + date);
+    for (int64_t i = 0; i < sum_row_count_AM; i++) {
+        seal::Ciphertext t = AM_rec;
+        evaluator.sub_inplace(t, AM_tab[i]);
+        relinearize(t);
+        save(t, result_AM, "inv_SUM_AM", true);
+    }
+    result_AM.close();
+
+    // LUT sumHM => divide to sumHM 1, and sumHM 2. sumHM = sumHM1 * 100 + sumHM2
+
+    std::cout << "Readtable for sum HM" << std::endl;
+    const CipherTable& HM_tab = session.Table("div_HM_input", div_row_count_HM);
+
+    // Read table
+
+    ArtifactOutput result_HM;
+    result_HM.open(resultDir + "/div_HM_" + date);
+    for (int64_t i = 0; i < div_row_count_HM; i++) {
+        seal::Ciphertext t = HM_rec;
+        evaluator.sub_inplace(t, HM_tab[i]);
+        relinearize(t);
+        save(t, result_HM, "div_HM", true);
+    }
+    result_HM.close();
+
+    std::cout << "===End===" << std::endl;
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    relinearize.Report("Step3_CS2");
+    save.Report("Step3_CS2");
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Evaluates the 1/SUM_AM and div_HM PIR queries, combines them and
+ * subtracts the inv_100 input table.
+ *
+ * @param[in] session CS session (PublicKey, GaloisKey, RelinKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] resultDir Directory for pir_SUM_AM_DIV_HM, Fin_AM1HM1 and inv_100
+ * @return Exit status
+ */
+int Step5CS3(FHESession& session, const std::string& date, const std::string& resultDir) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& evaluator = session.evaluator;
+    auto& galoisKey = session.galoisKey;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << slot_count << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t sum_row_count_AM = session.manifest.rowsAMInv;
+    int64_t inv100_row = session.manifest.rows100Inv;
+    int64_t div_row_count_HM = session.manifest.rowsDivHM;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    // Read output table
+
+    const OutputTable& output_AM1 = session.Output("inv_SUM_AM_output1", sum_row_count_AM);
+    const OutputTable& output_AM2 = session.Output("inv_SUM_AM_output2", sum_row_count_AM);
+
+    std::vector<seal::Ciphertext> res_a1, res_a2;
+    seal::Ciphertext AM_rec1, AM_rec2;
+    for (int64_t i = 0; i < sum_row_count_AM; i++) {
+        seal::Ciphertext t;
+        res_a1.push_back(t);
+        res_a2.push_back(t);
+    }
+
+    const OutputTable& output_HM1 = session.Output("div_HM_output1", div_row_count_HM);
+    const OutputTable& output_HM2 = session.Output("div_HM_output2", div_row_count_HM);
+
+    std::vector<seal::Ciphertext> res_h1, res_h2;
+    seal::Ciphertext HM_rec1, HM_rec2;
+    for (int64_t i = 0; i < div_row_count_HM; i++) {
+        seal::Ciphertext t;
+        res_h1.push_back(t);
+        res_h2.push_back(t);
+    }
+
+    const std::string& s1 = date;
+    const std::string& s2 = resultDir;
+
+    ////////////////////////////////////////////////////////////////////
+
+    std::cout << "===Main===" << std::endl;
+
+    // Read index and PIR query from file
+
+    std::cout << "===Reading query from DS===" << std::endl;
+    ArtifactInput PIRqueryFile(s2 + "/pir_SUM_AM_DIV_HM_" + s1);
+    seal::Ciphertext ct_query_AM0, ct_query_AM1, ct_query_HM0, ct_query_HM1;
+    ct_query_AM0.load(context, PIRqueryFile);
+    ct_query_AM1.load(context, PIRqueryFile);
+    ct_query_HM0.load(context, PIRqueryFile);
+    ct_query_HM1.load(context, PIRqueryFile);
+    PIRqueryFile.close();
+
+    std::cout << "Reading query from DS > OK" << std::endl;
+    std::cout << "LUT Processing" << std::endl;
+
+    // Both halves of a table share the selectors of their query
+
+    std::vector<seal::Ciphertext> select_AM = RowSelectors(evaluator, relinearize, ct_query_AM0, ct_query_AM1, sum_row_count_AM, galoisKey);
+    std::vector<seal::Ciphertext> select_HM = RowSelectors(evaluator, relinearize, ct_query_HM0, ct_query_HM1, div_row_count_HM, galoisKey);
+
+    ParallelLoop("pir");
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t i = 0; i < sum_row_count_AM; i++) {
+        seal::Ciphertext temp_a1 = select_AM[i];
+        seal::Ciphertext temp_a2 = select_AM[i];
+        output_AM1.MultiplyRow(evaluator, temp_a1, i);
+        output_AM2.MultiplyRow(evaluator, temp_a2, i);
+        relinearize(temp_a1);
+        relinearize(temp_a2);
+        res_a1[i] = temp_a1;
+        res_a2[i] = temp_a2;
+    }
+
+    ParallelLoop("pir");
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t i = 0; i < div_row_count_HM; i++) {
+        seal::Ciphertext temp_h1 = select_HM[i];
+        seal::Ciphertext temp_h2 = select_HM[i];
+        output_HM1.MultiplyRow(evaluator, temp_h1, i);
+        output_HM2.MultiplyRow(evaluator, temp_h2, i);
+        relinearize(temp_h1);
+        relinearize(temp_h2);
+        res_h1[i] = temp_h1;
+        res_h2[i] = temp_h2;
+    }
+
+    // Result sum
+
+    std::cout << "===Sum Result===" << std::endl;
+    AM_rec1 = res_a1[0];
+    AM_rec2 = res_a2[0];
+    for (int i = 1; i < sum_row_count_AM; i++) {
+        evaluator.add_inplace(AM_rec1, res_a1[i]);
+        evaluator.add_inplace(AM_rec2, res_a2[i]);
+    }
+    std::cout << "AM Size after relinearization: " << AM_rec1.size() << std::endl;
+
+    HM_rec1 = res_h1[0];
+    HM_rec2 = res_h2[0];
+    for (int i = 1; i < div_row_count_HM; i++) {
+        evaluator.add_inplace(HM_rec1, res_h1[i]);
+        evaluator.add_inplace(HM_rec2, res_h2[i]);
+    }
+    std::cout << "HM Size after relinearization: " << HM_rec1.size() << std::endl;
+
+    seal::Ciphertext ct_AM1 = AM_rec1, ct_AM2 = AM_rec2, ct_HM1 = HM_rec1, ct_HM2 = HM_rec2;
+
+    ParallelLoop("sum");
+    TotalSum(evaluator, {&ct_AM1, &ct_AM2, &ct_HM1, &ct_HM2}, row_size, galoisKey);
+
+    seal::Ciphertext fin_AM1HM1, fin_AM1HM2, fin_AM2HM1, fin_AM1HM2AM2HM1;
+    fin_AM1HM1 = ct_AM1;
+    fin_AM1HM2 = ct_AM1;
+    fin_AM2HM1 = ct_AM2;
+    evaluator.multiply_inplace(fin_AM1HM1, ct_HM1);
+    evaluator.multiply_inplace(fin_AM1HM2, ct_HM2);
+    evaluator.multiply_inplace(fin_AM2HM1, ct_HM1);
+    fin_AM1HM2AM2HM1 = fin_AM1HM2;
+    evaluator.add_inplace(fin_AM1HM2AM2HM1, fin_AM2HM1);
+    relinearize(fin_AM1HM1);
+    relinearize(fin_AM1HM2AM2HM1);
+
+    ArtifactOutput result_am1hm1;
+    result_am1hm1.open(s2 + "/Fin_AM1HM1_" + s1);
+    save(fin_AM1HM1, result_am1hm1, "Fin_AM1HM1");
+    result_am1hm1.close();
+
+    // LUT sumAM => 1/sumAM
+
+    std::cout << "Read table for sum 1/AM" << std::endl;
+    const CipherTable& inv_tab = session.Table("inv_100_input", inv100_row);
+
+    // Read table
+    ArtifactOutput result_inv;
+    result_inv.open(s2 + "/inv_100_" + s1);
+
+    for (int64_t i = 0; i < inv100_row; i++) {
+        seal::Ciphertext inv_input = fin_AM1HM2AM2HM1;
+        evaluator.sub_inplace(inv_input, inv_tab[i]);
+        relinearize(inv_input);
+        save(inv_input, result_inv, "inv_100", true);
+    }
+    result_inv.close();
+
+    std::cout << "===End===" << std::endl;
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    relinearize.Report("Step5_CS3");
+    save.Report("Step5_CS3");
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Evaluates the inv_100 PIR query and adds Fin_AM1HM1 to produce
+ * the final encrypted result.
+ *
+ * @param[in] session CS session (PublicKey, GaloisKey, RelinKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] resultDir Directory for pir_inv, Fin_AM1HM1 and finalRes
+ * @return Exit status
+ */
+int Step7CS4(FHESession& session, const std::string& date, const std::string& resultDir) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& evaluator = session.evaluator;
+    auto& galoisKey = session.galoisKey;
+    Relinearizer relinearize(session.evaluator, session.relinKey);
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << slot_count << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t inv100_row = session.manifest.rows100Inv;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    // Read output table
+
+    const OutputTable& output_inv = session.Output("inv_100_output", inv100_row);
+
+    std::vector<seal::Ciphertext> res_a;
+    seal::Ciphertext sum_result_a;
+
+    for (int64_t i = 0; i < inv100_row; i++) {
+        res_a.push_back(seal::Ciphertext());
+    }
+
+    ////////////////////////////////////////////////////////////////////
+
+    std::cout << "===Main===" << std::endl;
+
+    // Read index and PIR query from file
+
+    std::cout << "===Reading query from DS===" << std::endl;
+
+    ArtifactInput PIRqueryFile(resultDir + "/pir_inv_" + date);
+    seal::Ciphertext ct_query_inv0, ct_query_inv1;
+    ct_query_inv0.load(context, PIRqueryFile);
+    ct_query_inv1.load(context, PIRqueryFile);
+    PIRqueryFile.close();
+
+    std::cout << "Reading query from DS > OK" << std::endl;
+    std::cout << "LUT Processing" << std::endl;
+
+    auto startLUT = std::chrono::high_resolution_clock::now();
+
+    std::vector<seal::Ciphertext> select_inv = RowSelectors(evaluator, relinearize, ct_query_inv0, ct_query_inv1, inv100_row, galoisKey);
+
+    ParallelLoop("pir");
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t i = 0; i < inv100_row; i++) {
+        seal::Ciphertext t = select_inv[i];
+        output_inv.MultiplyRow(evaluator, t, i);
+        relinearize(t);
+        res_a[i] = t;
+    }
+
+    // Result sum
+
+    std::cout << "===Sum Result===" << std::endl;
+
+    sum_result_a = res_a[0];
+    for (int i = 1; i < inv100_row; i++) {
+        evaluator.add_inplace(sum_result_a, res_a[i]);
+    }
+
+    auto endLUT = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffLUT = endLUT - startLUT;
+    std::cout << "Runtime of LUT: " << diffLUT.count() << "s" << std::endl;
+    auto startTotalSum = std::chrono::high_resolution_clock::now();
+
+    seal::Ciphertext fin_res = sum_result_a;
+    TotalSum(evaluator, fin_res, row_size, galoisKey);
+
+    auto endTotalSum = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffTotalSum = endTotalSum - startTotalSum;
+    std::cout << "Runtime for one time totalSum: " << diffTotalSum.count() << "s" << std::endl;
+
+    ArtifactInput read_hmam(resultDir + "/Fin_AM1HM1_" + date);
+    seal::Ciphertext am1hm1;
+    am1hm1.load(context, read_hmam);
+    read_hmam.close();
+
+    evaluator.add_inplace(fin_res, am1hm1);
+
+    std::cout << "Save Result" << std::endl;
+
+    ArtifactOutput save_fin;
+    save_fin.open(resultDir + "/finalRes_" + date);
+    save(fin_res, save_fin, "finalRes", true);
+    save_fin.close();
+
+    std::cout << "===End===" << std::endl;
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    relinearize.Report("Step7_CS4");
+    save.Report("Step7_CS4");
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+#endif // SMART_CS_STEPS_HPP
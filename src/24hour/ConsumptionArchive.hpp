@@ -0,0 +1,368 @@
+/**
+ * @file ConsumptionArchive.hpp
+ * @brief Binary archive of daily consumption, one fixed-size block per day
+**/
+
+#ifndef SMART_CONSUMPTIONARCHIVE_HPP
+#define SMART_CONSUMPTIONARCHIVE_HPP
+
+#include "ConsumptionData.hpp"
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+/**
+ * Layout, native byte order:
+ *
+ *   ArchiveHeader
+ *   day 0:  DayHeader, ARCHIVE_HOURS labels of ARCHIVE_LABEL bytes,
+ *           ARCHIVE_HOURS x meters float32 readings, hour-major
+ *   day 1:  ...
+ *
+ * Every block has the same size, so day d starts at
+ * sizeof(ArchiveHeader) + d * BlockBytes(meters) and the day count follows
+ * from the file size. Days are stored in date order, which keeps lookups a
+ * binary search and lets a backfill append later days. Hours missing from a
+ * day are zero-filled and excluded by DayHeader::hours. The checksum covers
+ * the labels and readings of the block.
+ */
+
+#define ARCHIVE_MAGIC "SGARCH1"
+#define ARCHIVE_HOURS 24
+#define ARCHIVE_LABEL 32
+
+struct ArchiveHeader {
+
+    char magic[8];
+    uint32_t meters;
+    uint32_t hours;
+    uint32_t labelBytes;
+    uint32_t reserved;
+
+};
+
+struct DayHeader {
+
+    char date[16];
+    uint32_t hours;
+    uint32_t reserved;
+    uint64_t checksum;
+
+};
+
+/**
+ * @brief Bytes of one day block.
+ *
+ * @param[in] meters Meters per hour
+ * @return Block size, a multiple of 8
+ */
+size_t BlockBytes(int64_t meters) {
+
+    size_t bytes = sizeof(DayHeader) + ARCHIVE_HOURS * ARCHIVE_LABEL + ARCHIVE_HOURS * meters * sizeof(float);
+    return (bytes + 7) & ~size_t(7);
+
+}
+
+/**
+ * @brief FNV-1a over a byte range.
+ *
+ * @param[in] data First byte
+ * @param[in] size Number of bytes
+ * @return 64-bit hash
+ */
+uint64_t ArchiveChecksum(const char* data, size_t size) {
+
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return hash;
+
+}
+
+/**
+ * @brief Date of a daily file, its name without directory and extension.
+ *
+ * @param[in] path e.g. DateWiseData/NormalWinso/2014/2014-01-01.txt
+ * @return e.g. 2014-01-01
+ */
+std::string DateOfFile(const std::string& path) {
+
+    size_t slash = path.find_last_of('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return (dot == std::string::npos) ? name : name.substr(0, dot);
+
+}
+
+/**
+ * @brief Writes the file header of a new archive.
+ *
+ * @param[in,out] out Archive stream at offset 0
+ * @param[in] meters Meters per hour
+ */
+void WriteArchiveHeader(std::ostream& out, int64_t meters) {
+
+    ArchiveHeader header = {};
+    std::memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.meters = meters;
+    header.hours = ARCHIVE_HOURS;
+    header.labelBytes = ARCHIVE_LABEL;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+}
+
+/**
+ * @brief Appends one day block.
+ *
+ * @param[in,out] out Archive stream at the end of the last block
+ * @param[in] date Date of the day, YYYY-MM-DD
+ * @param[in] day Parsed day, at most ARCHIVE_HOURS hours of the archive's meter count
+ * @param[in] meters Meters per hour of the archive
+ */
+void WriteArchiveDay(std::ostream& out, const std::string& date, const ConsumptionMatrix& day, int64_t meters) {
+
+    if (day.hours > ARCHIVE_HOURS || (day.hours > 0 && day.meters != meters)) {
+        throw std::invalid_argument(date + ": " + std::to_string(day.hours) + " hours of " + std::to_string(day.meters)
+            + " meters, archive holds " + std::to_string(ARCHIVE_HOURS) + " of " + std::to_string(meters));
+    }
+
+    std::vector<char> block(BlockBytes(meters), 0);
+    DayHeader* header = reinterpret_cast<DayHeader*>(block.data());
+    std::strncpy(header->date, date.c_str(), sizeof(header->date) - 1);
+    header->hours = day.hours;
+
+    char* labels = block.data() + sizeof(DayHeader);
+    float* values = reinterpret_cast<float*>(labels + ARCHIVE_HOURS * ARCHIVE_LABEL);
+    for (int64_t h = 0; h < day.hours; h++) {
+        std::strncpy(labels + h * ARCHIVE_LABEL, day.times[h].c_str(), ARCHIVE_LABEL - 1);
+        const double* x = day.Hour(h);
+        for (int64_t m = 0; m < meters; m++) {
+            values[h * meters + m] = x[m];
+        }
+    }
+    header->checksum = ArchiveChecksum(labels, block.size() - sizeof(DayHeader));
+    out.write(block.data(), block.size());
+
+}
+
+/**
+ * @brief Read-only view of an archive file. Any day and hour is reachable
+ * without reading the others; the file is mapped, not loaded.
+ */
+class ConsumptionArchive {
+
+public:
+
+    /**
+     * @param[in] path Archive written by ConvertArchive
+     */
+    explicit ConsumptionArchive(const std::string& path) : path(path) {
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open archive " + path);
+        }
+        struct stat info;
+        fstat(fd, &info);
+        length = info.st_size;
+        if (length < sizeof(ArchiveHeader)) {
+            close(fd);
+            throw std::runtime_error(path + " is not a consumption archive");
+        }
+        base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (base == MAP_FAILED) {
+            throw std::runtime_error("Cannot map archive " + path);
+        }
+
+        const ArchiveHeader* header = static_cast<const ArchiveHeader*>(base);
+        if (std::memcmp(header->magic, ARCHIVE_MAGIC, sizeof(header->magic)) != 0
+            || header->hours != ARCHIVE_HOURS || header->labelBytes != ARCHIVE_LABEL) {
+            munmap(base, length);
+            throw std::runtime_error(path + " is not a consumption archive");
+        }
+        meters = header->meters;
+        days = (length - sizeof(ArchiveHeader)) / BlockBytes(meters);
+
+    }
+
+    ~ConsumptionArchive() {
+
+        munmap(base, length);
+
+    }
+
+    ConsumptionArchive(const ConsumptionArchive&) = delete;
+    ConsumptionArchive& operator=(const ConsumptionArchive&) = delete;
+
+    int64_t Days() const {
+
+        return days;
+
+    }
+
+    int64_t Meters() const {
+
+        return meters;
+
+    }
+
+    /**
+     * @param[in] day Day index
+     * @return Date of the day
+     */
+    std::string Date(int64_t day) const {
+
+        return std::string(Header(day)->date);
+
+    }
+
+    /**
+     * @brief Looks a date up.
+     *
+     * @param[in] date YYYY-MM-DD
+     * @return Day index, or -1 when the archive does not hold the date
+     */
+    int64_t Find(const std::string& date) const {
+
+        int64_t low = 0, high = days;
+        while (low < high) {
+            int64_t mid = (low + high) / 2;
+            if (std::strcmp(Header(mid)->date, date.c_str()) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return (low < days && date == Header(low)->date) ? low : -1;
+
+    }
+
+    /**
+     * @brief Readings of one hour as stored, meters contiguous.
+     *
+     * @param[in] day Day index
+     * @param[in] hour Hour index
+     * @return First reading of the hour
+     */
+    const float* Hour(int64_t day, int64_t hour) const {
+
+        const char* labels = reinterpret_cast<const char*>(Header(day)) + sizeof(DayHeader);
+        return reinterpret_cast<const float*>(labels + ARCHIVE_HOURS * ARCHIVE_LABEL) + hour * meters;
+
+    }
+
+    /**
+     * @brief One day as Step1 consumes it, after checking its checksum.
+     *
+     * @param[in] day Day index
+     * @return Day in the ReadConsumption layout
+     */
+    ConsumptionMatrix Day(int64_t day) const {
+
+        const DayHeader* header = Header(day);
+        const char* labels = reinterpret_cast<const char*>(header) + sizeof(DayHeader);
+        if (ArchiveChecksum(labels, BlockBytes(meters) - sizeof(DayHeader)) != header->checksum) {
+            throw std::runtime_error(path + ": checksum mismatch for " + Date(day));
+        }
+
+        ConsumptionMatrix matrix;
+        matrix.hours = header->hours;
+        matrix.meters = meters;
+        matrix.values.resize(matrix.hours * meters);
+        for (int64_t h = 0; h < matrix.hours; h++) {
+            matrix.times.emplace_back(labels + h * ARCHIVE_LABEL);
+            const float* x = Hour(day, h);
+            std::copy(x, x + meters, matrix.values.begin() + h * meters);
+        }
+        return matrix;
+
+    }
+
+    /**
+     * @param[in] date YYYY-MM-DD
+     * @return Day in the ReadConsumption layout
+     */
+    ConsumptionMatrix Day(const std::string& date) const {
+
+        int64_t day = Find(date);
+        if (day < 0) {
+            throw std::out_of_range(path + " has no day " + date);
+        }
+        return Day(day);
+
+    }
+
+private:
+
+    const DayHeader* Header(int64_t day) const {
+
+        const char* blocks = static_cast<const char*>(base) + sizeof(ArchiveHeader);
+        return reinterpret_cast<const DayHeader*>(blocks + day * BlockBytes(meters));
+
+    }
+
+    std::string path;
+    void* base = nullptr;
+    size_t length = 0;
+    int64_t meters = 0;
+    int64_t days = 0;
+
+};
+
+/**
+ * @brief Process-wide mapping of an archive, so a resident process or a
+ * backfill over many days maps it once. It is mapped again when the file
+ * changed since, e.g. after ConvertArchive --append; callers still holding
+ * the old mapping keep it until they release it.
+ *
+ * @param[in] archiveFile Archive written by ConvertArchive
+ * @return Shared archive
+ */
+std::shared_ptr<const ConsumptionArchive> OpenArchive(const std::string& archiveFile) {
+
+    struct Mapped {
+
+        std::shared_ptr<const ConsumptionArchive> archive;
+        off_t size = 0;
+        ino_t inode = 0;
+
+    };
+    static std::mutex openMutex;
+    static std::map<std::string, Mapped> opened;
+
+    struct stat info;
+    if (stat(archiveFile.c_str(), &info) != 0) {
+        throw std::runtime_error("Cannot open archive " + archiveFile);
+    }
+    std::lock_guard<std::mutex> lock(openMutex);
+    Mapped& mapped = opened[archiveFile];
+    if (!mapped.archive || mapped.size != info.st_size || mapped.inode != info.st_ino) {
+        mapped.archive = std::make_shared<const ConsumptionArchive>(archiveFile);
+        mapped.size = info.st_size;
+        mapped.inode = info.st_ino;
+    }
+    return mapped.archive;
+
+}
+
+/**
+ * @brief Readings of a day from its CSV file, or from an archive when one is
+ * given, in which case the date is taken from the file name.
+ *
+ * @param[in] inputFile Daily file, e.g. DateWiseData/NormalWinso/2014/2014-01-01.txt
+ * @param[in] archiveFile Archive written by ConvertArchive, or empty
+ * @return Parsed day
+ */
+ConsumptionMatrix ReadDay(const std::string& inputFile, const std::string& archiveFile) {
+
+    if (archiveFile.empty()) {
+        return ReadConsumption(inputFile);
+    }
+    return OpenArchive(archiveFile)->Day(DateOfFile(inputFile));
+
+}
+
+#endif // SMART_CONSUMPTIONARCHIVE_HPP
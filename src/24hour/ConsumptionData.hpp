@@ -0,0 +1,207 @@
+/**
+ * @file ConsumptionData.hpp
+ * @brief Daily consumption files parsed into a dense hour x meter matrix
+**/
+
+#ifndef SMART_CONSUMPTIONDATA_HPP
+#define SMART_CONSUMPTIONDATA_HPP
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Readings of one day. Hour h occupies values[h * meters, (h + 1) * meters),
+ * hours are sorted by their TimeSlot label.
+ */
+struct ConsumptionMatrix {
+
+    int64_t hours = 0;
+    int64_t meters = 0;
+    std::vector<std::string> times;
+    std::vector<double> values;
+
+    /**
+     * @brief Readings of one hour, meters contiguous
+     *
+     * @param[in] hour Hour index
+     * @return First reading of the hour
+     */
+    const double* Hour(int64_t hour) const {
+
+        return values.data() + hour * meters;
+
+    }
+
+};
+
+/**
+ * @brief Parses a daily consumption file held in memory.
+ *
+ * The format is the one ReadData accepted: an optional "TimeSlot,..." header,
+ * then one "label,reading,reading,..." line per hour. Empty lines are
+ * skipped, and a repeated label keeps its first line. Every hour must have
+ * the same number of readings.
+ *
+ * @param[in] begin First byte
+ * @param[in] end One past the last byte
+ * @param[in] name File name for error messages
+ * @return Parsed day
+ */
+ConsumptionMatrix ParseConsumption(const char* begin, const char* end, const std::string& name = "input") {
+
+    ConsumptionMatrix day;
+    std::vector<std::string> times;
+    std::vector<double> values;
+    values.reserve((end - begin) / 6);
+    int64_t meters = -1;
+    int64_t lineNumber = 0;
+
+    for (const char* line = begin; line < end; ) {
+        const char* newline = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        const char* stop = newline ? newline : end;
+        const char* next = newline ? newline + 1 : end;
+        if (stop > line && stop[-1] == '\r') {
+            stop--;
+        }
+        lineNumber++;
+
+        const char* comma = static_cast<const char*>(std::memchr(line, ',', stop - line));
+        const char* labelEnd = comma ? comma : stop;
+        if (labelEnd == line || (labelEnd - line == 8 && std::memcmp(line, "TimeSlot", 8) == 0)) {
+            line = next;
+            continue;
+        }
+
+        int64_t count = 0;
+        for (const char* field = labelEnd; field < stop; count++) {
+            field++; // Past the comma
+            if (field == stop) {
+                break; // A trailing comma ends the line, as getline(..., ',') did
+            }
+            while (field < stop && (*field == ' ' || *field == '\t')) {
+                field++;
+            }
+            double reading;
+            auto result = std::from_chars(field, stop, reading);
+            if (result.ec != std::errc()) {
+                throw std::invalid_argument(name + ":" + std::to_string(lineNumber) + ": bad reading");
+            }
+            values.push_back(reading);
+            field = result.ptr;
+            while (field < stop && (*field == ' ' || *field == '\t')) {
+                field++;
+            }
+            if (field < stop && *field != ',') {
+                throw std::invalid_argument(name + ":" + std::to_string(lineNumber) + ": bad reading");
+            }
+        }
+
+        if (meters < 0) {
+            meters = count;
+        } else if (count != meters) {
+            throw std::invalid_argument(name + ":" + std::to_string(lineNumber) + ": " + std::to_string(count)
+                + " readings, expected " + std::to_string(meters));
+        }
+        times.emplace_back(line, labelEnd);
+        line = next;
+    }
+
+    day.meters = std::max<int64_t>(meters, 0);
+
+    // Hours in label order, first line of a repeated label, as a std::map gave
+    std::vector<int64_t> order(times.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&times](int64_t a, int64_t b) { return times[a] < times[b]; });
+    order.erase(std::unique(order.begin(), order.end(), [&times](int64_t a, int64_t b) { return times[a] == times[b]; }), order.end());
+
+    bool inOrder = order.size() == times.size() && std::is_sorted(order.begin(), order.end());
+    day.hours = order.size();
+    if (inOrder) {
+        day.times = std::move(times);
+        day.values = std::move(values);
+    } else {
+        day.values.resize(day.hours * day.meters);
+        for (int64_t h = 0; h < day.hours; h++) {
+            day.times.push_back(times[order[h]]);
+            std::copy_n(values.begin() + order[h] * day.meters, day.meters, day.values.begin() + h * day.meters);
+        }
+    }
+    return day;
+
+}
+
+/**
+ * @brief Maps a daily consumption file and parses it in place.
+ *
+ * @param[in] filename Path to the data file
+ * @return Parsed day, empty when the file cannot be opened
+ */
+ConsumptionMatrix ReadConsumption(const std::string& filename) {
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return ConsumptionMatrix();
+    }
+    struct stat info;
+    fstat(fd, &info);
+    size_t length = info.st_size;
+    if (length == 0) {
+        close(fd);
+        return ConsumptionMatrix();
+    }
+
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("Cannot map " + filename);
+    }
+    madvise(mapped, length, MADV_SEQUENTIAL);
+
+    const char* text = static_cast<const char*>(mapped);
+    try {
+        ConsumptionMatrix day = ParseConsumption(text, text + length, filename);
+        munmap(mapped, length);
+        return day;
+    } catch (...) {
+        munmap(mapped, length);
+        throw;
+    }
+
+}
+
+/**
+ * @brief Daily files of a directory in name order, i.e. in date order for
+ * the YYYY-MM-DD.txt files of DateWiseData.
+ *
+ * @param[in] dir Data directory
+ * @return Paths of the *.txt files
+ */
+std::vector<std::string> DailyFiles(const std::string& dir) {
+
+    std::vector<std::string> files;
+    if (DIR* handle = opendir(dir.c_str())) {
+        while (dirent* entry = readdir(handle)) {
+            std::string name = entry->d_name;
+            if (name.size() > 4 && name.compare(name.size() - 4, 4, ".txt") == 0) {
+                files.push_back(dir + "/" + name);
+            }
+        }
+        closedir(handle);
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+
+}
+
+#endif // SMART_CONSUMPTIONDATA_HPP
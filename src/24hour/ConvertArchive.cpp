@@ -0,0 +1,109 @@
+#include "ConsumptionArchive.hpp"
+#include <chrono>
+#include <iostream>
+
+// Converts DateWiseData CSV files into a consumption archive.
+// Usage: ConvertArchive <archive> <dataDir> [dataDir...] [--append]
+// Every YYYY-MM-DD.txt file of the directories becomes one day block, in
+// date order. Pass several directories for a multi-year archive, or
+// --append to add later days to an existing archive.
+// Step1_CS1 --archive <archive> then reads the day named by its input file.
+
+int main(int argc, char** argv) {
+
+    std::vector<std::string> args(argv, argv + argc);
+    bool append = std::find(args.begin(), args.end(), "--append") != args.end();
+    args.erase(std::remove(args.begin(), args.end(), "--append"), args.end());
+    if (args.size() < 3) {
+        std::cout << "Usage: ConvertArchive <archive> <dataDir> [dataDir...] [--append]" << std::endl;
+        return 1;
+    }
+    std::string archiveFile = args[1];
+
+    std::vector<std::string> files;
+    for (size_t i = 2; i < args.size(); i++) {
+        std::vector<std::string> dirFiles = DailyFiles(args[i]);
+        files.insert(files.end(), dirFiles.begin(), dirFiles.end());
+    }
+    std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+        return DateOfFile(a) < DateOfFile(b);
+    });
+    if (files.empty()) {
+        std::cout << "No daily files found" << std::endl;
+        return 1;
+    }
+
+    // Days must stay in date order, also across an append
+    int64_t meters = -1;
+    std::string lastDate;
+    if (append) {
+        try {
+            ConsumptionArchive existing(archiveFile);
+            meters = existing.Meters();
+            if (existing.Days() > 0) {
+                lastDate = existing.Date(existing.Days() - 1);
+            }
+        } catch (const std::exception& e) {
+            std::cout << "Cannot append: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::ofstream out(archiveFile, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+    if (!out.is_open()) {
+        std::cout << "Cannot write " << archiveFile << std::endl;
+        return 1;
+    }
+    // Empty days before the first one with readings wait for the meter count
+    std::vector<std::pair<std::string, ConsumptionMatrix>> waiting;
+    int64_t written = 0;
+    for (const std::string& file : files) {
+        std::string date = DateOfFile(file);
+        if (!lastDate.empty() && date <= lastDate) {
+            std::cout << "Skipping " << file << ": " << date << " is not after " << lastDate << std::endl;
+            continue;
+        }
+        try {
+            ConsumptionMatrix day = ReadConsumption(file);
+            lastDate = date;
+            if (meters < 0) {
+                if (day.hours == 0 || day.meters == 0) {
+                    std::cout << file << " has no readings" << std::endl;
+                    waiting.emplace_back(date, std::move(day));
+                    continue;
+                }
+                meters = day.meters;
+                WriteArchiveHeader(out, meters);
+                for (const auto& empty : waiting) {
+                    WriteArchiveDay(out, empty.first, empty.second, meters);
+                    written++;
+                }
+                waiting.clear();
+            }
+            WriteArchiveDay(out, date, day, meters);
+            written++;
+        } catch (const std::exception& e) {
+            std::cout << "Cannot convert " << file << ": " << e.what() << std::endl;
+            return 1;
+        }
+    }
+    out.close();
+    std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+    if (out.fail()) {
+        std::cout << "Cannot write " << archiveFile << std::endl;
+        return 1;
+    }
+    if (meters < 0) {
+        std::cout << "No daily file has readings" << std::endl;
+        return 1;
+    }
+
+    ConsumptionArchive archive(archiveFile);
+    std::cout << "Wrote " << written << " days to " << archiveFile << ": " << archive.Days() << " days of "
+        << archive.Meters() << " meters, " << BlockBytes(archive.Meters()) << " bytes per day" << std::endl;
+    std::cout << "Conversion runtime is: " << diff.count() << "s" << std::endl;
+
+    return 0;
+
+}
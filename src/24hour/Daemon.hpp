@@ -0,0 +1,107 @@
+/**
+ * @file Daemon.hpp
+ * @brief Local socket job server used by the CS and TA daemons
+**/
+
+#ifndef SMART_DAEMON_HPP
+#define SMART_DAEMON_HPP
+
+#include <functional>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "SGSimulation.hpp"
+
+/**
+ * @brief Splits a job line on whitespace.
+ *
+ * @param[in] line Job line, e.g. "Step3_CS2 2014-01-01 Result"
+ * @return Step name followed by its arguments
+ */
+std::vector<std::string> SplitJob(const std::string& line) {
+
+    std::vector<std::string> args;
+    std::istringstream ss(line);
+    std::string arg;
+    while (ss >> arg) {
+        args.push_back(arg);
+    }
+    return args;
+
+}
+
+/**
+ * @brief Accepts jobs on a unix socket until a "shutdown" job arrives.
+ *
+ * Each connection sends one newline-terminated job and receives the exit
+ * status of the handler (or "ERR <what>") followed by a newline.
+ *
+ * @param[in] socketPath Filesystem path of the socket
+ * @param[in] handler Runs one job and returns its exit status
+ * @return Exit status of the daemon
+ */
+int ServeJobs(const std::string& socketPath, const std::function<int(const std::vector<std::string>&)>& handler) {
+
+    int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0) {
+        perror("socket");
+        return 1;
+    }
+
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(socketPath.c_str());
+
+    if (bind(server, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(server, 8) < 0) {
+        perror("bind");
+        close(server);
+        return 1;
+    }
+
+    std::cout << "Listening on " << socketPath << std::endl;
+
+    bool running = true;
+    while (running) {
+        int client = accept(server, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+
+        std::string line;
+        char c;
+        while (read(client, &c, 1) == 1 && c != '\n') {
+            line.push_back(c);
+        }
+
+        std::vector<std::string> args = SplitJob(line);
+        std::string reply;
+        if (args.empty()) {
+            reply = "ERR empty job\n";
+        } else if (args[0] == "shutdown") {
+            running = false;
+            reply = "0\n";
+        } else {
+            auto startJob = std::chrono::high_resolution_clock::now();
+            try {
+                reply = std::to_string(handler(args)) + "\n";
+            } catch (const std::exception& e) {
+                reply = std::string("ERR ") + e.what() + "\n";
+            }
+            std::chrono::duration<double> diffJob = std::chrono::high_resolution_clock::now() - startJob;
+            std::cout << "Job " << line << " took " << diffJob.count() << "s" << std::endl;
+        }
+
+        if (write(client, reply.c_str(), reply.size()) < 0) {
+            perror("write");
+        }
+        close(client);
+    }
+
+    close(server);
+    unlink(socketPath.c_str());
+    return 0;
+
+}
+
+#endif // SMART_DAEMON_HPP
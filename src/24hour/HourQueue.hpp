@@ -0,0 +1,150 @@
+/**
+ * @file HourQueue.hpp
+ * @brief Hour-ready notifications between the CS and TA processes
+**/
+
+#ifndef SMART_HOURQUEUE_HPP
+#define SMART_HOURQUEUE_HPP
+
+#include "SGSimulation.hpp"
+
+/**
+ * @brief One-way queue of finished hours, kept as an append-only file in the
+ * result directory. The producer appends an hour once its artifact files are
+ * closed; the consumer waits for the next line, so the two parties overlap
+ * hour by hour instead of step by step.
+ *
+ * Neither side waits for the other to open the queue. The consumer removes
+ * the file after its last hour, so the next day starts from an empty queue;
+ * after an aborted run the stale file has to be removed (script.py clears
+ * Result/ every day).
+ *
+ * A failing producer appends HourQueue::ABORTED instead of an hour; a
+ * producer that goes out of scope before its last hour does so itself, and
+ * script.py appends it for a step that crashed. Next() also gives up after
+ * SG_STREAM_TIMEOUT seconds (default 600) without a new hour, so the
+ * consumer never waits forever.
+ */
+class HourQueue {
+
+public:
+
+    static const int64_t ABORTED = -1;
+
+    /**
+     * @param[in] path Queue file
+     * @param[in] hours Hours the producer publishes
+     */
+    explicit HourQueue(const std::string& path, int64_t hours = 24) : path(path), hours(hours) {
+
+        const char* timeout = std::getenv("SG_STREAM_TIMEOUT");
+        timeoutSeconds = timeout ? std::stod(timeout) : 600.0;
+
+    }
+
+    ~HourQueue() {
+
+        if (out.is_open() && published < hours) {
+            Abort();
+        }
+
+    }
+
+    /**
+     * @brief Announces that every artifact of an hour is written.
+     *
+     * @param[in] hour Hour
+     */
+    void Publish(int64_t hour) {
+
+        if (!out.is_open()) {
+            out.open(path, std::ios::trunc);
+        }
+        out << hour << std::endl;
+        published++;
+
+    }
+
+    /**
+     * @brief Tells the consumer that no further hour will come.
+     */
+    void Abort() {
+
+        if (!out.is_open()) {
+            out.open(path, std::ios::app);
+        }
+        out << ABORTED << std::endl;
+        published = hours;
+
+    }
+
+    /**
+     * @brief Waits for the next finished hour.
+     *
+     * @return Hour, or ABORTED if the producer failed or timed out
+     */
+    int64_t Next() {
+
+        auto start = std::chrono::steady_clock::now();
+        auto waited = [&]() {
+            std::chrono::duration<double> diff = std::chrono::steady_clock::now() - start;
+            if (diff.count() < timeoutSeconds) {
+                return false;
+            }
+            std::cout << path << ": no hour for " << timeoutSeconds << "s, giving up" << std::endl;
+            return true;
+        };
+
+        while (!in.is_open()) {
+            in.open(path);
+            if (!in.is_open()) {
+                if (waited()) {
+                    return ABORTED;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+
+        std::string line;
+        for (;;) {
+            std::streampos position = in.tellg();
+            if (std::getline(in, line) && !in.eof()) {
+                int64_t hour = std::stoll(line);
+                if (hour == ABORTED) {
+                    std::cout << path << ": producer aborted" << std::endl;
+                }
+                return hour;
+            }
+            // Nothing new, or a line still being written
+            in.clear();
+            in.seekg(position);
+            if (waited()) {
+                return ABORTED;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+    }
+
+    /**
+     * @brief Removes the queue once the consumer has read every hour.
+     */
+    void Finish() {
+
+        in.close();
+        std::remove(path.c_str());
+
+    }
+
+private:
+
+    std::string path;
+    int64_t hours;
+    int64_t published = 0;
+    double timeoutSeconds;
+    std::ofstream out;
+    std::ifstream in;
+
+};
+
+#endif // SMART_HOURQUEUE_HPP
@@ -0,0 +1,246 @@
+/**
+ * @file IndexSearch.hpp
+ * @brief Sign-change search over decoded LUT differences (AVX-512, AVX2 or scalar)
+**/
+
+#ifndef SMART_INDEXSEARCH_HPP
+#define SMART_INDEXSEARCH_HPP
+
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SMART_INDEXSEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Direction of the sign change between slot j and slot j + 1.
+ *
+ * Falling: d[j] >= 0 and d[j + 1] < 0. Rising: d[j] <= 0 and d[j + 1] > 0.
+ */
+enum class Crossing { Falling, Rising };
+
+/**
+ * @brief Table row and column selected by a search.
+ */
+struct SlotIndex {
+
+    int64_t row = 0;
+    int64_t col = 0;
+    bool found = false;
+
+};
+
+/**
+ * @brief Scalar search of one row. Returns the first j in [begin, end) where
+ * the sign changes in the given direction, or where d[j] == 0 when zeroHit.
+ *
+ * @param[in] d Decoded slots (d[j + 1] is read up to d[end])
+ * @param[in] begin First slot
+ * @param[in] end One past the last slot
+ * @param[in] direction Direction of the sign change
+ * @param[in] zeroHit An exact zero is a match by itself
+ * @return Slot of the match, or -1
+ */
+inline int64_t FindEventScalar(const int64_t* d, int64_t begin, int64_t end, Crossing direction, bool zeroHit) {
+
+    for (int64_t j = begin; j < end; j++) {
+        if (zeroHit && d[j] == 0) {
+            return j;
+        }
+        bool change = (direction == Crossing::Falling)
+            ? (d[j] >= 0 && d[j + 1] < 0)
+            : (d[j] <= 0 && d[j + 1] > 0);
+        if (change) {
+            return j;
+        }
+    }
+    return -1;
+
+}
+
+#ifdef SMART_INDEXSEARCH_X86
+
+/**
+ * @brief FindEventScalar, four slots per compare.
+ */
+__attribute__((target("avx2")))
+inline int64_t FindEventAVX2(const int64_t* d, int64_t begin, int64_t end, Crossing direction, bool zeroHit) {
+
+    const __m256i zero = _mm256_setzero_si256();
+    int64_t j = begin;
+    for (; j + 4 <= end; j += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(d + j));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(d + j + 1));
+        __m256i mask;
+        if (direction == Crossing::Falling) {
+            // !(a < 0) && (b < 0)
+            mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(zero, a), _mm256_cmpgt_epi64(zero, b));
+        } else {
+            // !(a > 0) && (b > 0)
+            mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(a, zero), _mm256_cmpgt_epi64(b, zero));
+        }
+        if (zeroHit) {
+            mask = _mm256_or_si256(mask, _mm256_cmpeq_epi64(a, zero));
+        }
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+        if (bits != 0) {
+            return j + __builtin_ctz(bits);
+        }
+    }
+    return FindEventScalar(d, j, end, direction, zeroHit);
+
+}
+
+/**
+ * @brief FindEventScalar, eight slots per compare.
+ */
+__attribute__((target("avx512f")))
+inline int64_t FindEventAVX512(const int64_t* d, int64_t begin, int64_t end, Crossing direction, bool zeroHit) {
+
+    const __m512i zero = _mm512_setzero_si512();
+    int64_t j = begin;
+    for (; j + 8 <= end; j += 8) {
+        __m512i a = _mm512_loadu_si512((const void*)(d + j));
+        __m512i b = _mm512_loadu_si512((const void*)(d + j + 1));
+        __mmask8 mask;
+        if (direction == Crossing::Falling) {
+            mask = _mm512_cmpge_epi64_mask(a, zero) & _mm512_cmplt_epi64_mask(b, zero);
+        } else {
+            mask = _mm512_cmple_epi64_mask(a, zero) & _mm512_cmpgt_epi64_mask(b, zero);
+        }
+        if (zeroHit) {
+            mask |= _mm512_cmpeq_epi64_mask(a, zero);
+        }
+        if (mask != 0) {
+            return j + __builtin_ctz(mask);
+        }
+    }
+    return FindEventScalar(d, j, end, direction, zeroHit);
+
+}
+
+#endif
+
+/**
+ * @brief Search kernel: "scalar", "avx2" or "avx512".
+ */
+using FindEventFn = int64_t (*)(const int64_t*, int64_t, int64_t, Crossing, bool);
+
+/**
+ * @brief Widest kernel the CPU supports. SG_SEARCH=scalar|avx2|avx512 overrides it.
+ *
+ * @return Kernel name
+ */
+inline std::string SearchKernelName() {
+
+    const char* forced = std::getenv("SG_SEARCH");
+    if (forced) {
+        return forced;
+    }
+#ifdef SMART_INDEXSEARCH_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return "avx512";
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return "avx2";
+    }
+#endif
+    return "scalar";
+
+}
+
+/**
+ * @brief Kernel for a name. Unsupported names fall back to scalar.
+ *
+ * @param[in] name Kernel name
+ * @return Kernel
+ */
+inline FindEventFn SearchKernel(const std::string& name) {
+
+#ifdef SMART_INDEXSEARCH_X86
+    if (name == "avx512" && __builtin_cpu_supports("avx512f")) {
+        return FindEventAVX512;
+    }
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) {
+        return FindEventAVX2;
+    }
+#endif
+    return FindEventScalar;
+
+}
+
+/**
+ * @brief Default kernel, the widest one the CPU supports.
+ *
+ * @return Kernel
+ */
+inline FindEventFn BestSearchKernel() {
+
+    static const FindEventFn best = SearchKernel(SearchKernelName());
+    return best;
+
+}
+
+/**
+ * @brief Finds the slot closest to zero in one decoded row.
+ *
+ * The first match in slots [0, rowSize) wins; of the two slots around a sign
+ * change the one with the smaller magnitude is selected (the left one on a
+ * tie). Slot rowSize is read as the right neighbour of the last slot when
+ * the row holds it.
+ *
+ * @param[in] d Decoded row
+ * @param[in] rowSize Slots searched
+ * @param[in] direction Direction of the sign change
+ * @param[in] zeroHit An exact zero is a match by itself
+ * @param[in] kernel Kernel, the widest supported one by default
+ * @return Selected column, or -1
+ */
+inline int64_t FindInRow(const std::vector<int64_t>& d, int64_t rowSize, Crossing direction, bool zeroHit, FindEventFn kernel = nullptr) {
+
+    if (kernel == nullptr) {
+        kernel = BestSearchKernel();
+    }
+    // Every compared d[j + 1] has to exist
+    int64_t end = std::min<int64_t>(rowSize, (int64_t)d.size() - 1);
+    int64_t j = kernel(d.data(), 0, end, direction, zeroHit);
+    if (j < 0) {
+        return -1;
+    }
+    return (std::llabs(d[j]) <= std::llabs(d[j + 1])) ? j : j + 1;
+
+}
+
+/**
+ * @brief Finds the table entry closest to zero in decoded LUT differences.
+ * Rows are scanned in order and the first row with a match wins.
+ *
+ * @param[in] rows Decoded rows of one function
+ * @param[in] rowSize Slots searched per row
+ * @param[in] direction Direction of the sign change
+ * @param[in] zeroHit An exact zero is a match by itself
+ * @param[in] kernel Kernel, the widest supported one by default
+ * @return Selected row and column
+ */
+inline SlotIndex FindCrossing(const std::vector<std::vector<int64_t>>& rows, int64_t rowSize, Crossing direction, bool zeroHit, FindEventFn kernel = nullptr) {
+
+    SlotIndex index;
+    for (int64_t i = 0; i < (int64_t)rows.size(); i++) {
+        int64_t col = FindInRow(rows[i], rowSize, direction, zeroHit, kernel);
+        if (col >= 0) {
+            index.row = i;
+            index.col = col;
+            index.found = true;
+            break;
+        }
+    }
+    return index;
+
+}
+
+#endif // SMART_INDEXSEARCH_HPP
@@ -1,15 +1,19 @@
-#include "SGSimulation.hpp"
+#include "Manifest.hpp"
+#include "TableWriter.hpp"
 
 int main(int argc, char** argv){
 
     auto startWhole = std::chrono::high_resolution_clock::now();
 
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    int64_t meterNum = MeterCount(args);
+    bool plainTables = HasFlag(args, "--plain");
+
     auto context = CreateContextFromParams(PARAMS_FILEPATH, seal::scheme_type::bfv);
     auto publicKey = LoadKey<seal::PublicKey>(context, PUBLIC_KEY_FILEPATH);
     auto relinKey = LoadKey<seal::RelinKeys>(context, RELIN_KEY_FILEPATH);
 
-    seal::Encryptor encryptor(context, publicKey);
-    seal::Evaluator evaluator(context);
     seal::BatchEncoder batchEncoder(context);
 
     size_t slot_count = batchEncoder.slot_count();
@@ -21,17 +25,17 @@ int main(int argc, char** argv){
 
     std::cout << "Precision = " << precision << std::endl;
     std::cout << "////////////////////////////" << std::endl;
-    std::cout << "InputArith, from " << precision * METER_NUM * std::log(52) << " to " << precision * METER_NUM * std::log(6002) << "." << std::endl;
-    std::cout << "InputHarm, from " << precision3 * METER_NUM * std::log(52) << " to " << precision3 * METER_NUM * std::log(6002) << "." << std::endl;
+    std::cout << "InputArith, from " << precision * meterNum * std::log(52) << " to " << precision * meterNum * std::log(6002) << "." << std::endl;
+    std::cout << "InputHarm, from " << precision3 * meterNum * std::log(52) << " to " << precision3 * meterNum * std::log(6002) << "." << std::endl;
 
     std::vector<int64_t> inputArith;
     std::vector<int64_t> inputHarm;
 
-    for (int64_t i = precision * METER_NUM * std::log(52); i < precision * METER_NUM * std::log(6002); i++) {
+    for (int64_t i = precision * meterNum * std::log(52); i < precision * meterNum * std::log(6002); i++) {
         inputArith.push_back(i);
     }
 
-    for (int64_t i = precision3 * METER_NUM / std::log(52); i > precision3 * METER_NUM / std::log(6002); i--) {
+    for (int64_t i = precision3 * meterNum / std::log(52); i > precision3 * meterNum / std::log(6002); i--) {
         inputHarm.push_back(i);
     }
 
@@ -45,8 +49,8 @@ int main(int argc, char** argv){
 
     for (int64_t i = 0; i < inputArith.size(); i++) {
         double temp_Ar = inputArith[i] / precision;
-        double temps_AM = std::pow(2, 7) * (temp_Ar / METER_NUM);
-        double temps_AM_real = temp_Ar / METER_NUM;
+        double temps_AM = std::pow(2, 7) * (temp_Ar / meterNum);
+        double temps_AM_real = temp_Ar / meterNum;
         int64_t temps_AM_INT = (int64_t)temps_AM;
         if (std::abs(temps_AM - temps_AM_INT) >= 0.5) {
             temps_AM_INT++;
@@ -71,7 +75,7 @@ int main(int argc, char** argv){
 
     for (int64_t i = 0; i < inputHarm.size(); i++) {
         double temp_Ha = inputHarm[i] / precision3;
-        double temps_HM = pow(2, 7) * (METER_NUM / temp_Ha);
+        double temps_HM = pow(2, 7) * (meterNum / temp_Ha);
         int64_t temps_HM_INT = (int64_t)temps_HM;
         if (abs(temps_HM - temps_HM_INT) >= 0.5) {
             temps_HM_INT += 1;
@@ -120,255 +124,29 @@ int main(int argc, char** argv){
     std::cout << "input 1/shm from " << sum_HM_inout[0] << " to " << sum_HM_inout[sum_HM_inout.size() - 1] << std::endl;
     std::cout << "Size: " << sum_HM_inout.size() << std::endl;
 
-    // Save table (input AM)
-
-    std::ofstream arith_in;
-    arith_in.open("Table/AM_input_" + std::to_string(METER_NUM), std::ios::binary);
-
-    int64_t row_ar = ceil(double(inputArith.size()) / double(row_size));
-
-    std::vector<int64_t> inputArith_row;
-    for (int64_t s = 0; s < row_ar; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < inputArith.size()) {
-                inputArith_row.push_back(inputArith[s * row_size + k]);
-            } else {
-                inputArith_row.push_back(50000);
-            }
-        }
-        inputArith_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_ina;
-        seal::Ciphertext temp_enc_ina;
-        batchEncoder.encode(inputArith_row, temp_pla_ina);
-        encryptor.encrypt(temp_pla_ina, temp_enc_ina);
-        temp_enc_ina.save(arith_in);
-        inputArith_row.clear();
-
-    }
-    arith_in.close();
-
-    // Save table (input HM)
-
-    std::ofstream harm_in;
-    harm_in.open("Table/HM_input_" + std::to_string(METER_NUM), std::ios::binary);
-    int64_t row_ha = ceil(double(inputHarm.size()) / double(row_size));
-
-    std::vector<int64_t> inputHarm_row;
-    for (int64_t s = 0; s < row_ha; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < inputHarm.size()) {
-                inputHarm_row.push_back(inputHarm[s * row_size + k]);
-            } else {
-                inputHarm_row.push_back(10000);
-            }
-        }
-        inputHarm_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_inh;
-        seal::Ciphertext temp_enc_inh;
-        batchEncoder.encode(inputHarm_row, temp_pla_inh);
-        encryptor.encrypt(temp_pla_inh, temp_enc_inh);
-        temp_enc_inh.save(harm_in);
-        inputHarm_row.clear();
-
-    }
-    harm_in.close();
-
-    // Save table (output AM)
-
-    std::ofstream arith_out;
-    arith_out.open("Table/AM_output_" + std::to_string(METER_NUM), std::ios::binary);
-    int64_t row_arout = ceil(double(AM_part.size()) / double(row_size));
-
-    std::vector<int64_t> outputArith_row;
-    for (int64_t s = 0; s < row_arout; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < AM_part.size()) {
-                outputArith_row.push_back(AM_part[s * row_size + k]);
-            } else {
-                outputArith_row.push_back(500);
-            }
-        }
-        outputArith_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_outa;
-        seal::Ciphertext temp_enc_outa;
-        batchEncoder.encode(outputArith_row, temp_pla_outa);
-        encryptor.encrypt(temp_pla_outa, temp_enc_outa);
-        temp_enc_outa.save(arith_out);
-        outputArith_row.clear();
-
-    }
-    arith_out.close();
-
-    // Save table (output HM)
-
-    std::ofstream h_out;
-    h_out.open("Table/HM_output_" + std::to_string(METER_NUM), std::ios::binary);
-    int64_t row_hout = ceil(double(HM_part.size()) / double(row_size));
-
-    std::vector<int64_t> outputh_row;
-    for (int64_t s = 0; s < row_hout; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < HM_part.size()) {
-                outputh_row.push_back(HM_part[s * row_size + k]);
-            } else {
-                outputh_row.push_back(500);
-            }
-        }
-        outputh_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_outh;
-        seal::Ciphertext temp_enc_outh;
-        batchEncoder.encode(outputh_row, temp_pla_outh);
-        encryptor.encrypt(temp_pla_outh, temp_enc_outh);
-        temp_enc_outh.save(h_out);
-        outputh_row.clear();
-
-    }
-    h_out.close();
-
-    // Save table (sumHM input)
-
-    std::ofstream sumhm_in;
-    sumhm_in.open("Table/div_HM_input_" + std::to_string(METER_NUM), std::ios::binary);
-    int64_t row_sumhin = ceil(double(sum_HM_inout.size()) / double(row_size));
-
-    std::vector<int64_t> inputSumH_row;
-    for (int64_t s = 0; s < row_sumhin; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < sum_HM_inout.size()) {
-                inputSumH_row.push_back(sum_HM_inout[s * row_size + k]);
-            } else {
-                inputSumH_row.push_back(60000);
-            }
-        }
-        inputSumH_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_sumh;
-        seal::Ciphertext temp_enc_sumh;
-        batchEncoder.encode(inputSumH_row, temp_pla_sumh);
-        encryptor.encrypt(temp_pla_sumh, temp_enc_sumh);
-        temp_enc_sumh.save(sumhm_in);
-        inputSumH_row.clear();
-
-    }
-    sumhm_in.close();
-
-    // sumHM output divided part
+    // Split outputs: the steps combine the /100 and %100 halves
 
+    std::vector<int64_t> div_HM_out1, div_HM_out2;
     int64_t HM1_max = 0, HM1_min = 1000, HM2_max = 0, HM2_min = 1000;
-
-    std::ofstream harm_out1;
-    harm_out1.open("Table/div_HM_output1_" + std::to_string(METER_NUM), std::ios::binary);
-    std::ofstream harm_out2;
-    harm_out2.open("Table/div_HM_output2_" + std::to_string(METER_NUM), std::ios::binary);
-
-    int64_t row_haout = ceil(double(sum_HM_inout.size()) / double(row_size));
-    std::cout << "Divided HM output table." << std::endl;
-    std::vector<int64_t> outputHarm_row1, outputHarm_row2;
-
-    for (int64_t s = 0; s < row_haout; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < sum_HM_inout.size()) {
-                outputHarm_row1.push_back(sum_HM_inout[s * row_size + k] / 100);
-                outputHarm_row2.push_back(sum_HM_inout[s * row_size + k] % 100);
-                if ((sum_HM_inout[s * row_size + k] / 100) > HM1_max) HM1_max = (sum_HM_inout[s * row_size + k] / 100);
-                if ((sum_HM_inout[s * row_size + k] / 100) < HM1_min) HM1_min = (sum_HM_inout[s * row_size + k] / 100);
-                if ((sum_HM_inout[s * row_size + k] % 100) > HM2_max) HM2_max = (sum_HM_inout[s * row_size + k] % 100);
-                if ((sum_HM_inout[s * row_size + k] % 100) < HM2_min) HM2_min = (sum_HM_inout[s * row_size + k] % 100);
-            } else {
-                outputHarm_row1.push_back(600);
-                outputHarm_row2.push_back(1);
-            }
-        }
-        outputHarm_row1.resize(slot_count);
-        outputHarm_row2.resize(slot_count);
-
-        seal::Plaintext temp_pla_outh1, temp_pla_outh2;
-        seal::Ciphertext temp_enc_outh1, temp_enc_outh2;
-        batchEncoder.encode(outputHarm_row1, temp_pla_outh1);
-        encryptor.encrypt(temp_pla_outh1, temp_enc_outh1);
-        temp_enc_outh1.save(harm_out1);
-        outputHarm_row1.clear();
-        batchEncoder.encode(outputHarm_row2, temp_pla_outh2);
-        encryptor.encrypt(temp_pla_outh2, temp_enc_outh2);
-        temp_enc_outh2.save(harm_out2);
-        outputHarm_row2.clear();
+    for (int64_t value : sum_HM_inout) {
+        div_HM_out1.push_back(value / 100);
+        div_HM_out2.push_back(value % 100);
+        HM1_max = std::max(HM1_max, value / 100);
+        HM1_min = std::min(HM1_min, value / 100);
+        HM2_max = std::max(HM2_max, value % 100);
+        HM2_min = std::min(HM2_min, value % 100);
     }
-    harm_out1.close();
-    harm_out2.close();
-
-    // sum_AM input table
-
-    std::ofstream sumam_in;
-    sumam_in.open("Table/SUM_AM_input_" + std::to_string(METER_NUM), std::ios::binary);
-    int64_t row_sumain = ceil(double(sum_AM_in.size()) / double(row_size));
-    std::vector<int64_t> inputSumA_row;
-
-    for (int64_t s = 0; s < row_sumain; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < sum_AM_in.size()) {
-                inputSumA_row.push_back(sum_AM_in[s * row_size + k]);
-            } else {
-                inputSumA_row.push_back(60000);
-            }
-        }
-        inputSumA_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_suma;
-        seal::Ciphertext temp_enc_suma;
-        batchEncoder.encode(inputSumA_row, temp_pla_suma);
-        encryptor.encrypt(temp_pla_suma, temp_enc_suma);
-        temp_enc_suma.save(sumam_in);
-        inputSumA_row.clear();
-
-    }
-    sumam_in.close();
-
-    // 1/sum_AM output table
 
+    std::vector<int64_t> inv_SUM_AM_out1, inv_SUM_AM_out2;
     int64_t AM1_max = 0, AM1_min = 100, AM2_max = 0, AM2_min = 100;
-    std::ofstream lnv_am_out1;
-    lnv_am_out1.open("Table/inv_SUM_AM_output1_" + std::to_string(METER_NUM), std::ios::binary);
-    std::ofstream lnv_am_out2;
-    lnv_am_out2.open("Table/inv_SUM_AM_output2_" + std::to_string(METER_NUM), std::ios::binary);
-
-    int64_t row_sumaout = ceil(double(sum_AM_out.size()) / double(row_size));
-    std::vector<int64_t> inputSumA_row1, inputSumA_row2;
-
-    for (int64_t s = 0; s < row_sumaout; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < sum_AM_out.size()) {
-                inputSumA_row1.push_back(sum_AM_out[s * row_size + k] / 100);
-                inputSumA_row2.push_back(sum_AM_out[s * row_size + k] % 100);
-                if ((sum_AM_out[s * row_size + k] / 100) > AM1_max) AM1_max = (sum_AM_out[s * row_size + k] / 100);
-                if ((sum_AM_out[s * row_size + k] / 100) < AM1_min) AM1_min = (sum_AM_out[s * row_size + k] / 100);
-                if ((sum_AM_out[s * row_size + k] % 100) > AM2_max) AM2_max = (sum_AM_out[s * row_size + k] % 100);
-                if ((sum_AM_out[s * row_size + k] % 100) < AM2_min) AM2_min = (sum_AM_out[s * row_size + k] % 100);
-            } else {
-                inputSumA_row1.push_back(1);
-                inputSumA_row2.push_back(1);
-            }
-        }
-        inputSumA_row1.resize(slot_count);
-        inputSumA_row2.resize(slot_count);
-
-        seal::Plaintext temp_pla_suma1, temp_pla_suma2;
-        seal::Ciphertext temp_enc_suma1, temp_enc_suma2;
-        batchEncoder.encode(inputSumA_row1, temp_pla_suma1);
-        encryptor.encrypt(temp_pla_suma1, temp_enc_suma1);
-        temp_enc_suma1.save(lnv_am_out1);
-        inputSumA_row1.clear();
-        batchEncoder.encode(inputSumA_row2, temp_pla_suma2);
-        encryptor.encrypt(temp_pla_suma2, temp_enc_suma2);
-        temp_enc_suma2.save(lnv_am_out2);
-        inputSumA_row2.clear();
-
+    for (int64_t value : sum_AM_out) {
+        inv_SUM_AM_out1.push_back(value / 100);
+        inv_SUM_AM_out2.push_back(value % 100);
+        AM1_max = std::max(AM1_max, value / 100);
+        AM1_min = std::min(AM1_min, value / 100);
+        AM2_max = std::max(AM2_max, value % 100);
+        AM2_min = std::min(AM2_min, value % 100);
     }
-    lnv_am_out1.close();
-    lnv_am_out2.close();
 
     // Add one table for N/100
 
@@ -395,41 +173,57 @@ int main(int argc, char** argv){
     std::cout << "input inv from " << inv_in[0] << " to " << inv_in[inv_in.size() - 1] << std::endl;
     std::cout << "output inv from " << inv_out[0] << " to " << inv_out[inv_out.size() - 1] << std::endl;
 
-    std::ofstream lnv_100_in;
-    lnv_100_in.open("Table/inv_100_input_" + std::to_string(METER_NUM), std::ios::binary);
-    std::ofstream lnv_100_out;
-    lnv_100_out.open("Table/inv_100_output_" + std::to_string(METER_NUM), std::ios::binary);
-
-    int64_t row_100in = ceil(double(inv_in.size()) / double(row_size));
-
-    std::vector<int64_t> input100_row, output100_row;
-    for (int64_t s = 0; s < row_100in; s++) {
-        for (int64_t k = 0; k < row_size; k++) {
-            if ((s * row_size + k) < inv_in.size()) {
-                input100_row.push_back(inv_in[s * row_size + k]);
-                output100_row.push_back(inv_out[s * row_size + k]);
-            } else {
-                input100_row.push_back(60000);
-                output100_row.push_back(1);
-            }
-        }
-        input100_row.resize(slot_count);
-        output100_row.resize(slot_count);
-
-        seal::Plaintext temp_pla_100in, temp_pla_100out;
-        seal::Ciphertext temp_enc_100in, temp_enc_100out;
-        batchEncoder.encode(input100_row, temp_pla_100in);
-        encryptor.encrypt(temp_pla_100in, temp_enc_100in);
-        temp_enc_100in.save(lnv_100_in);
-        input100_row.clear();
-        batchEncoder.encode(output100_row, temp_pla_100out);
-        encryptor.encrypt(temp_pla_100out, temp_enc_100out);
-        temp_enc_100out.save(lnv_100_out);
-        output100_row.clear();
-
+    // Record what the steps need to know about this table set
+
+    TableManifest manifest;
+    manifest.meterNum = meterNum;
+    manifest.plainOutputs = plainTables;
+    manifest.tableSizeAM = inputArith.size();
+    manifest.tableSizeHM = inputHarm.size();
+    manifest.tableSizeAMInv = sum_AM_in.size();
+    manifest.tableSize100Inv = inv_in.size();
+    manifest.tableSizeDivHM = sum_HM_inout.size();
+    manifest.SetRowSize(row_size);
+    manifest.amInputFirst = inputArith[0];
+    manifest.amInputLast = inputArith[inputArith.size() - 1];
+    manifest.hmInputFirst = inputHarm[0];
+    manifest.hmInputLast = inputHarm[inputHarm.size() - 1];
+    manifest.sumAMInputFirst = sum_AM_in[0];
+    manifest.sumAMInputLast = sum_AM_in[sum_AM_in.size() - 1];
+    manifest.divHMInputFirst = sum_HM_inout[0];
+    manifest.divHMInputLast = sum_HM_inout[sum_HM_inout.size() - 1];
+    manifest.inv100InputFirst = inv_in[0];
+    manifest.inv100InputLast = inv_in[inv_in.size() - 1];
+
+    // Save tables: rows of all tables are encrypted on every thread, each
+    // file is written in row order. The last row of a table is padded with
+    // the manifest's value.
+
+    std::string suffix = "_" + std::to_string(meterNum);
+    TableWriter tables(context, publicKey, plainTables, Threads().threads);
+    tables.AddInput("Table/AM_input" + suffix, inputArith, manifest.padAMInput);
+    tables.AddInput("Table/HM_input" + suffix, inputHarm, manifest.padHMInput);
+    tables.AddOutput("Table/AM_output" + suffix, AM_part, manifest.padAMOutput);
+    tables.AddOutput("Table/HM_output" + suffix, HM_part, manifest.padHMOutput);
+    tables.AddInput("Table/div_HM_input" + suffix, sum_HM_inout, manifest.padDivHMInput);
+    tables.AddOutput("Table/div_HM_output1" + suffix, div_HM_out1, manifest.padDivHMOutput1);
+    tables.AddOutput("Table/div_HM_output2" + suffix, div_HM_out2, manifest.padDivHMOutput2);
+    tables.AddInput("Table/SUM_AM_input" + suffix, sum_AM_in, manifest.padSumAMInput);
+    tables.AddOutput("Table/inv_SUM_AM_output1" + suffix, inv_SUM_AM_out1, manifest.padInvSumAMOutput1);
+    tables.AddOutput("Table/inv_SUM_AM_output2" + suffix, inv_SUM_AM_out2, manifest.padInvSumAMOutput2);
+    tables.AddInput("Table/inv_100_input" + suffix, inv_in, manifest.padInv100Input);
+    tables.AddOutput("Table/inv_100_output" + suffix, inv_out, manifest.padInv100Output);
+    tables.Run();
+
+    SaveManifest(manifest, ManifestPath(meterNum));
+    std::cout << "Saved " << ManifestPath(meterNum) << std::endl;
+
+    // Batched int64 slots hold values in (-t/2, t/2); larger districts need a bigger plain modulus
+
+    int64_t plainHalf = context.first_context_data()->parms().plain_modulus().value() / 2;
+    if (manifest.amInputLast >= plainHalf || manifest.hmInputFirst >= plainHalf || manifest.divHMInputLast >= plainHalf) {
+        std::cout << "WARNING: table inputs exceed the plain modulus range for " << meterNum << " meters" << std::endl;
     }
-    lnv_100_in.close();
-    lnv_100_out.close();
 
     auto endWhole = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double> diffWhole = endWhole - startWhole;
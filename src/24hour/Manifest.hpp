@@ -0,0 +1,209 @@
+/**
+ * @file Manifest.hpp
+ * @brief Table manifest written by MakeEncTab and read by every step
+**/
+
+#ifndef SMART_MANIFEST_HPP
+#define SMART_MANIFEST_HPP
+
+#include "SGSimulation.hpp"
+
+/**
+ * @brief Meter count, table sizes, row counts, input ranges and padding
+ * values of one generated table set.
+ */
+struct TableManifest {
+
+    int64_t meterNum = METER_NUM;
+    int64_t rowSize = 0;
+    int64_t plainOutputs = 0; // 1: LUT output tables are NTT-form plaintexts (MakeEncTab --plain)
+
+    int64_t tableSizeAM = TABLE_SIZE_AM;
+    int64_t tableSizeHM = TABLE_SIZE_HM;
+    int64_t tableSizeAMInv = TABLE_SIZE_AM_INV;
+    int64_t tableSize100Inv = TABLE_SIZE_100_INV;
+    int64_t tableSizeDivHM = TABLE_SIZE_DIV_HM;
+
+    int64_t rowsAM = 0;
+    int64_t rowsHM = 0;
+    int64_t rowsAMInv = 0;
+    int64_t rows100Inv = 0;
+    int64_t rowsDivHM = 0;
+
+    int64_t amInputFirst = 0;
+    int64_t amInputLast = 0;
+    int64_t hmInputFirst = 0;
+    int64_t hmInputLast = 0;
+    int64_t sumAMInputFirst = 0;
+    int64_t sumAMInputLast = 0;
+    int64_t divHMInputFirst = 0;
+    int64_t divHMInputLast = 0;
+    int64_t inv100InputFirst = 0;
+    int64_t inv100InputLast = 0;
+
+    // Entries filling the last row of each table, passed to TableWriter
+    int64_t padAMInput = 50000;
+    int64_t padHMInput = 10000;
+    int64_t padAMOutput = 500;
+    int64_t padHMOutput = 500;
+    int64_t padDivHMInput = 60000;
+    int64_t padDivHMOutput1 = 600;
+    int64_t padDivHMOutput2 = 1;
+    int64_t padSumAMInput = 60000;
+    int64_t padInvSumAMOutput1 = 1;
+    int64_t padInvSumAMOutput2 = 1;
+    int64_t padInv100Input = 60000;
+    int64_t padInv100Output = 1;
+
+    /**
+     * @brief Recomputes the row counts from the table sizes.
+     *
+     * @param[in] slotsPerRow Slots in one batch row
+     */
+    void SetRowSize(int64_t slotsPerRow) {
+
+        rowSize = slotsPerRow;
+        rowsAM = ceil((double)tableSizeAM / (double)rowSize);
+        rowsHM = ceil((double)tableSizeHM / (double)rowSize);
+        rowsAMInv = ceil((double)tableSizeAMInv / (double)rowSize);
+        rows100Inv = ceil((double)tableSize100Inv / (double)rowSize);
+        rowsDivHM = ceil((double)tableSizeDivHM / (double)rowSize);
+
+    }
+
+};
+
+/**
+ * @brief Manifest keys in file order.
+ *
+ * @return Pairs of key and member
+ */
+const std::vector<std::pair<std::string, int64_t TableManifest::*>>& ManifestFields() {
+
+    static const std::vector<std::pair<std::string, int64_t TableManifest::*>> fields = {
+        {"meter_num", &TableManifest::meterNum},
+        {"row_size", &TableManifest::rowSize},
+        {"plain_outputs", &TableManifest::plainOutputs},
+        {"table_size_am", &TableManifest::tableSizeAM},
+        {"table_size_hm", &TableManifest::tableSizeHM},
+        {"table_size_am_inv", &TableManifest::tableSizeAMInv},
+        {"table_size_100_inv", &TableManifest::tableSize100Inv},
+        {"table_size_div_hm", &TableManifest::tableSizeDivHM},
+        {"rows_am", &TableManifest::rowsAM},
+        {"rows_hm", &TableManifest::rowsHM},
+        {"rows_am_inv", &TableManifest::rowsAMInv},
+        {"rows_100_inv", &TableManifest::rows100Inv},
+        {"rows_div_hm", &TableManifest::rowsDivHM},
+        {"am_input_first", &TableManifest::amInputFirst},
+        {"am_input_last", &TableManifest::amInputLast},
+        {"hm_input_first", &TableManifest::hmInputFirst},
+        {"hm_input_last", &TableManifest::hmInputLast},
+        {"sum_am_input_first", &TableManifest::sumAMInputFirst},
+        {"sum_am_input_last", &TableManifest::sumAMInputLast},
+        {"div_hm_input_first", &TableManifest::divHMInputFirst},
+        {"div_hm_input_last", &TableManifest::divHMInputLast},
+        {"inv_100_input_first", &TableManifest::inv100InputFirst},
+        {"inv_100_input_last", &TableManifest::inv100InputLast},
+        {"pad_am_input", &TableManifest::padAMInput},
+        {"pad_hm_input", &TableManifest::padHMInput},
+        {"pad_am_output", &TableManifest::padAMOutput},
+        {"pad_hm_output", &TableManifest::padHMOutput},
+        {"pad_div_hm_input", &TableManifest::padDivHMInput},
+        {"pad_div_hm_output1", &TableManifest::padDivHMOutput1},
+        {"pad_div_hm_output2", &TableManifest::padDivHMOutput2},
+        {"pad_sum_am_input", &TableManifest::padSumAMInput},
+        {"pad_inv_sum_am_output1", &TableManifest::padInvSumAMOutput1},
+        {"pad_inv_sum_am_output2", &TableManifest::padInvSumAMOutput2},
+        {"pad_inv_100_input", &TableManifest::padInv100Input},
+        {"pad_inv_100_output", &TableManifest::padInv100Output},
+    };
+    return fields;
+
+}
+
+/**
+ * @brief Path of the manifest for a meter count.
+ *
+ * @param[in] meterNum Number of meters in the district
+ * @return Manifest path under Table/
+ */
+std::string ManifestPath(int64_t meterNum) {
+
+    return "Table/Manifest_" + std::to_string(meterNum);
+
+}
+
+/**
+ * @brief Reads the meter count from "--meters N", defaulting to METER_NUM.
+ *
+ * @param[in] args Command line arguments
+ * @return Number of meters
+ */
+int64_t MeterCount(const std::vector<std::string>& args) {
+
+    return std::stoll(GetOption(args, "--meters", std::to_string(METER_NUM)));
+
+}
+
+/**
+ * @brief Writes a manifest as "key value" lines.
+ *
+ * @param[in] manifest Manifest to save
+ * @param[in] filepath Destination path
+ */
+void SaveManifest(const TableManifest& manifest, const std::string& filepath) {
+
+    std::ofstream file(filepath);
+    for (const auto& field : ManifestFields()) {
+        file << field.first << " " << manifest.*(field.second) << std::endl;
+    }
+    file.close();
+
+}
+
+/**
+ * @brief Reads the manifest of a meter count. Without a manifest file the
+ * compile-time table sizes are used, which only match METER_NUM.
+ *
+ * @param[in] meterNum Number of meters in the district
+ * @param[in] rowSize Slots in one batch row of the loaded params
+ * @return Loaded manifest
+ */
+TableManifest LoadManifest(int64_t meterNum, int64_t rowSize) {
+
+    TableManifest manifest;
+    std::ifstream file(ManifestPath(meterNum));
+
+    if (!file.is_open()) {
+        if (meterNum != METER_NUM) {
+            throw std::invalid_argument("Missing " + ManifestPath(meterNum) + ", run MakeEncTab --meters " + std::to_string(meterNum));
+        }
+        std::cout << "No " << ManifestPath(meterNum) << ", using compiled table sizes" << std::endl;
+        manifest.meterNum = meterNum;
+        manifest.SetRowSize(rowSize);
+        return manifest;
+    }
+
+    std::map<std::string, int64_t> values;
+    std::string key;
+    int64_t value;
+    while (file >> key >> value) {
+        values[key] = value;
+    }
+    file.close();
+
+    for (const auto& field : ManifestFields()) {
+        auto found = values.find(field.first);
+        if (found != values.end()) {
+            manifest.*(field.second) = found->second;
+        }
+    }
+
+    if (manifest.rowSize != rowSize) {
+        throw std::invalid_argument("Manifest row size does not match the encryption parameters.");
+    }
+    return manifest;
+
+}
+
+#endif // SMART_MANIFEST_HPP
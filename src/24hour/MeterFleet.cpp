@@ -0,0 +1,96 @@
+#include "SGSimulation.hpp"
+#include "ConsumptionArchive.hpp"
+#include <sys/stat.h>
+
+// Simulates the meters of a district encrypting their own hourly readings.
+// Usage: MeterFleet <daily file> <spool dir> [--threads N] [--archive FILE]
+// Step1_CS1 --spool <spool dir> then only aggregates the ciphertexts.
+
+int main(int argc, char** argv) {
+
+    std::vector<std::string> args(argv, argv + argc);
+    std::string inputFile(argv[1]);     // s1
+    std::string spoolDir(argv[2]);      // s2
+    int64_t threadCount = std::stoll(GetOption(args, "--threads", std::to_string(std::thread::hardware_concurrency())));
+
+    std::cout << "Setting FHE" << std::endl;
+
+    auto context = CreateContextFromParams(PARAMS_FILEPATH, seal::scheme_type::bfv);
+    auto publicKey = LoadKey<seal::PublicKey>(context, PUBLIC_KEY_FILEPATH);
+
+    seal::BatchEncoder batchEncoder(context);
+
+    size_t slot_count = batchEncoder.slot_count();
+    size_t row_size = slot_count / 2;
+
+    mkdir(spoolDir.c_str(), 0755);
+
+    // Same hour ordering as Step1_CS1
+
+    ConsumptionMatrix day = ReadDay(inputFile, GetOption(args, "--archive", ""));
+    int64_t meterCount = day.meters;
+
+    // The whole day is quantized at once, hour-major like the readings
+    std::vector<int64_t> log_values, rec_log_values;
+    QuantizeHour(day.values.data(), day.values.size(), log_values, rec_log_values);
+
+    std::cout << "Meters: " << meterCount << ", hours: " << day.hours << ", threads: " << threadCount << std::endl;
+
+    // Meter k is simulated by thread k % threadCount, each thread owning an Encryptor
+
+    std::vector<double> threadTime(threadCount, 0.0);
+    auto startFleet = std::chrono::high_resolution_clock::now();
+
+    std::vector<std::thread> pool;
+    for (int64_t t = 0; t < threadCount; t++) {
+        pool.emplace_back([&, t]() {
+            auto startThread = std::chrono::high_resolution_clock::now();
+            seal::Encryptor encryptor(context, publicKey);
+
+            for (int64_t meter = t; meter < meterCount; meter += threadCount) {
+                for (int64_t hour = 0; hour < day.hours; hour++) {
+                    int64_t temp = log_values[hour * meterCount + meter];
+                    int64_t temp_rec = rec_log_values[hour * meterCount + meter];
+
+                    std::vector<int64_t> vec_log(row_size, temp);
+                    vec_log.resize(slot_count);
+                    std::vector<int64_t> vec_rec_log(row_size, temp_rec);
+                    vec_rec_log.resize(slot_count);
+
+                    seal::Plaintext poly_log, poly_rec_log;
+                    seal::Ciphertext log_enc, rec_log_enc;
+                    batchEncoder.encode(vec_log, poly_log);
+                    encryptor.encrypt(poly_log, log_enc);
+                    batchEncoder.encode(vec_rec_log, poly_rec_log);
+                    encryptor.encrypt(poly_rec_log, rec_log_enc);
+
+                    std::ofstream meterFile(SpoolPath(spoolDir, hour, meter), std::ios::binary);
+                    log_enc.save(meterFile);
+                    rec_log_enc.save(meterFile);
+                    meterFile.close();
+                }
+            }
+
+            std::chrono::duration<double> diffThread = std::chrono::high_resolution_clock::now() - startThread;
+            threadTime[t] = diffThread.count();
+        });
+    }
+    for (std::thread& worker : pool) {
+        worker.join();
+    }
+
+    auto endFleet = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffFleet = endFleet - startFleet;
+
+    int64_t encryptions = 2 * meterCount * day.hours;
+    double busy = std::accumulate(threadTime.begin(), threadTime.end(), 0.0);
+
+    std::cout << "Encryptions: " << encryptions << std::endl;
+    std::cout << "Fleet runtime is: " << diffFleet.count() << "s" << std::endl;
+    std::cout << "Throughput: " << encryptions / diffFleet.count() << " enc/s, "
+        << encryptions / busy << " enc/s per core" << std::endl;
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
@@ -0,0 +1,74 @@
+/**
+ * @file PIRQuery.hpp
+ * @brief Row selectors of the LUT PIR queries, shared by every table row
+**/
+
+#ifndef SMART_PIRQUERY_HPP
+#define SMART_PIRQUERY_HPP
+
+#include "Threads.hpp"
+
+/**
+ * @brief Rotations of a query by -j for j in [0, count).
+ *
+ * SEAL does not expose the key-switch decomposition, so rotations cannot be
+ * hoisted directly. Instead rotation j is derived from the already computed
+ * rotation j - 2^b by a single power-of-two rotation. Every rotation then
+ * costs one key switch, instead of one per NAF digit of j, and each level
+ * runs in parallel.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in] query Query ciphertext
+ * @param[in] count Number of rotations (table rows)
+ * @param[in] galoisKey GaloisKeys with the power-of-two steps
+ * @return Rotation j at index j
+ */
+std::vector<seal::Ciphertext> QueryRotations(seal::Evaluator& evaluator, const seal::Ciphertext& query, int64_t count, const seal::GaloisKeys& galoisKey) {
+
+    std::vector<seal::Ciphertext> rotations(count);
+    if (count == 0) {
+        return rotations;
+    }
+    rotations[0] = query;
+
+    // Level "step" fills [step, 2 * step) from [0, step)
+    for (int64_t step = 1; step < count; step *= 2) {
+        int64_t end = std::min(2 * step, count);
+        ParallelLoop("pir");
+        #pragma omp parallel for schedule(runtime)
+        for (int64_t j = step; j < end; j++) {
+            rotations[j] = rotations[j - step];
+            evaluator.rotate_rows_inplace(rotations[j], -step, galoisKey);
+        }
+    }
+    return rotations;
+
+}
+
+/**
+ * @brief Row selectors rotate(query1, -j) * query0 of a PIR query. Tables
+ * sharing one query (e.g. inv_SUM_AM_output1/2) reuse the same selectors.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in] relinearize Relinearizer of the calling step
+ * @param[in] query0 Column selector
+ * @param[in] query1 Row selector before rotation
+ * @param[in] count Number of table rows
+ * @param[in] galoisKey GaloisKeys
+ * @return Relinearized selector of row j at index j
+ */
+std::vector<seal::Ciphertext> RowSelectors(seal::Evaluator& evaluator, Relinearizer& relinearize, const seal::Ciphertext& query0, const seal::Ciphertext& query1, int64_t count, const seal::GaloisKeys& galoisKey) {
+
+    std::vector<seal::Ciphertext> selectors = QueryRotations(evaluator, query1, count, galoisKey);
+
+    ParallelLoop("pir");
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t j = 0; j < count; j++) {
+        evaluator.multiply_inplace(selectors[j], query0);
+        relinearize(selectors[j]);
+    }
+    return selectors;
+
+}
+
+#endif // SMART_PIRQUERY_HPP
@@ -0,0 +1,74 @@
+#include "Pipeline.hpp"
+
+// Runs every step of a date range in one process, without subprocesses,
+// per-step key loading or result files.
+// Usage: Pipeline <dataDir> <firstDate> <lastDate> [--result DIR]
+//        [--ptxt FILE] [--ctxt FILE] [--packed] [--batch] [--archive FILE]
+//        [--store memory|file] [--persist] [--days N] [--meters N] [--threads N]
+//        [--zero-pool N] [--zero-pool-threads T] [--zero-pool-file FILE]
+// Artifacts stay in memory by default; --persist also writes them to the
+// result directory, --store file uses the files alone as the Step binaries do.
+// --days N processes N days at once, each with Result/<date> and a share of
+// the threads; the ratio files are merged in date order.
+
+int main(int argc, char** argv) {
+
+    if (argc < 4) {
+        std::cout << "Usage: Pipeline <dataDir> <firstDate> <lastDate> [options]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "Setting FHE" << std::endl;
+
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    ConfigureArtifacts(args);
+    ConfigureZeroPool(args);
+
+    PipelineOptions options;
+    options.dataDir = argv[1];
+    options.resultDir = GetOption(args, "--result", options.resultDir);
+    options.ptxtFile = GetOption(args, "--ptxt", options.ptxtFile);
+    options.ctxtFile = GetOption(args, "--ctxt", options.ctxtFile);
+    options.packed = HasFlag(args, "--packed");
+    options.batch = HasFlag(args, "--batch");
+    options.archiveFile = GetOption(args, "--archive", "");
+
+    int days = std::stoi(GetOption(args, "--days", "1"));
+    if (days > 1) {
+        // Every day in flight runs its own OpenMP teams
+        Threads().threads = std::max(1, Threads().threads / days);
+        std::cout << "Days in flight: " << days << ", threads per day: " << Threads().threads << std::endl;
+    }
+    bool persist = HasFlag(args, "--persist");
+    if (GetOption(args, "--store", "memory") == "memory") {
+        Store().UseMemory(persist);
+    }
+    if (!Store().InMemory() || persist) {
+        mkdir(options.resultDir.c_str(), 0755);
+    }
+
+    auto startKeys = std::chrono::high_resolution_clock::now();
+    FHESession cs(true, false, MeterCount(args));
+    FHESession ta(false, true, MeterCount(args));
+    std::chrono::duration<double> diffKeys = std::chrono::high_resolution_clock::now() - startKeys;
+
+    std::vector<std::string> dates = DateRange(argv[2], argv[3]);
+    std::map<std::string, double> seconds;
+
+    auto startRun = std::chrono::high_resolution_clock::now();
+    int64_t done = RunDays(cs, ta, options, dates, days, seconds);
+    std::chrono::duration<double> diffRun = std::chrono::high_resolution_clock::now() - startRun;
+
+    std::cout << "===Pipeline===" << std::endl;
+    std::cout << "Days: " << done << ", store: " << (Store().InMemory() ? "memory" : "file") << std::endl;
+    std::cout << "Key loading: " << diffKeys.count() << "s (once)" << std::endl;
+    for (const auto& step : seconds) {
+        std::cout << step.first << ": " << step.second << "s, " << step.second / std::max<int64_t>(done, 1) << "s per day" << std::endl;
+    }
+    std::cout << "Whole runtime is: " << diffRun.count() << "s, " << diffRun.count() / std::max<int64_t>(done, 1) << "s per day" << std::endl;
+    ShowMemoryUsage(getpid());
+
+    return (done == (int64_t)dates.size()) ? 0 : 1;
+
+}
@@ -0,0 +1,221 @@
+/**
+ * @file Pipeline.hpp
+ * @brief Runs the CS and TA steps of one day in a single process
+**/
+
+#ifndef SMART_PIPELINE_HPP
+#define SMART_PIPELINE_HPP
+
+#include <sys/stat.h>
+#include "CSSteps.hpp"
+#include "TASteps.hpp"
+
+/**
+ * @brief Inputs and outputs of a pipeline run.
+ */
+struct PipelineOptions {
+
+    std::string dataDir;
+    std::string resultDir = "Result";
+    std::string ptxtFile = "ptxt_res/test2014.txt";
+    std::string ctxtFile = "ctxt_res/test2014.txt";
+    bool packed = false;
+    bool batch = false;
+    std::string archiveFile;
+
+};
+
+/**
+ * @brief Dates from first to last inclusive.
+ *
+ * @param[in] first First date, YYYY-MM-DD
+ * @param[in] last Last date, YYYY-MM-DD
+ * @return Every date of the range
+ */
+std::vector<std::string> DateRange(const std::string& first, const std::string& last) {
+
+    std::tm day = {};
+    std::istringstream(first) >> std::get_time(&day, "%Y-%m-%d");
+    day.tm_hour = 12; // Keeps mktime clear of DST changes
+
+    std::vector<std::string> dates;
+    for (int n = 0; n < 100000; n++) {
+        std::tm next = day;
+        next.tm_mday += n;
+        std::mktime(&next);
+        char text[11];
+        std::strftime(text, sizeof(text), "%Y-%m-%d", &next);
+        if (std::string(text) > last) {
+            break;
+        }
+        dates.push_back(text);
+    }
+    return dates;
+
+}
+
+/**
+ * @brief Runs Step1_CS1 to CheckRes for one day, the way script.py does.
+ * When a mod-switched artifact has no noise budget left, the switch is
+ * turned off for the rest of the run and the day starts over.
+ *
+ * @param[in] cs CS session (PublicKey, RelinKey, GaloisKey)
+ * @param[in] ta TA session (PublicKey, SecretKey)
+ * @param[in] options Pipeline inputs and outputs
+ * @param[in] date Date of the data
+ * @param[in] index Day number written in front of the ratios
+ * @param[in,out] seconds Runtime per step, added to
+ * @return Exit status of the first failing step, or 0
+ */
+int RunDay(FHESession& cs, FHESession& ta, const PipelineOptions& options, const std::string& date, int64_t index, std::map<std::string, double>& seconds) {
+
+    // Sizes of the ratio files before this day, for a rerun of the day
+    std::vector<std::pair<std::string, off_t>> ratioSizes;
+    for (const std::string& file : {options.ctxtFile, options.ptxtFile}) {
+        struct stat info;
+        ratioSizes.emplace_back(file, (stat(file.c_str(), &info) == 0) ? info.st_size : 0);
+    }
+
+    std::string inputFile = options.dataDir + "/" + date + ".txt";
+    const std::string& dir = options.resultDir;
+    std::vector<std::pair<std::string, std::function<int()>>> steps = {
+        {"Step1_CS1", [&]() { return Step1CS1(cs, inputFile, options.ptxtFile, dir, options.packed, "", false, options.archiveFile); }},
+        {"Step2_TA1", [&]() { return Step2TA1(ta, dir, options.batch); }},
+        {"Step3_CS2", [&]() { return Step3CS2(cs, date, dir); }},
+        {"Step4_TA2", [&]() { return Step4TA2(ta, date, dir); }},
+        {"Step5_CS3", [&]() { return Step5CS3(cs, date, dir); }},
+        {"Step6_TA3", [&]() { return Step6TA3(ta, date, dir); }},
+        {"Step7_CS4", [&]() { return Step7CS4(cs, date, dir); }},
+        {"CheckRes", [&]() { return CheckRes(ta, date, dir, options.ctxtFile); }},
+    };
+
+    int status = 0;
+    bool rerun = true, switchedOff = false;
+    while (rerun) {
+        rerun = false;
+        for (const auto& ratio : ratioSizes) {
+            truncate(ratio.first.c_str(), ratio.second);
+            std::ofstream out(ratio.first, std::ios::app);
+            out << index << ",";
+        }
+
+        for (const auto& step : steps) {
+            auto start = std::chrono::high_resolution_clock::now();
+            try {
+                status = step.second();
+            } catch (const NoiseBudgetError& e) {
+                std::cout << date << ": " << step.first << ": " << e.what() << std::endl;
+                status = 1;
+                // Fall back to full-level artifacts for this and every later day
+                Artifacts().modSwitch = false;
+                rerun = !switchedOff;
+                switchedOff = true;
+            } catch (const std::exception& e) {
+                std::cout << date << ": " << step.first << ": " << e.what() << std::endl;
+                status = 1;
+            }
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+            seconds[step.first] += diff.count();
+            if (status != 0) {
+                std::cout << date << ": " << step.first << " failed with " << status << std::endl;
+                break;
+            }
+        }
+        if (rerun) {
+            std::cout << date << ": running the day again with --no-mod-switch" << std::endl;
+            Store().Clear(dir);
+        }
+    }
+
+    // The next day must not pick up this day's artifacts
+    Store().Clear(dir);
+    return status;
+
+}
+
+/**
+ * @brief Runs a date range with up to workers days in flight at once.
+ *
+ * Day i keeps its artifacts under <resultDir>/<date> and its ratios in
+ * <ptxtFile>.<date> and <ctxtFile>.<date>. The ratio files are appended to
+ * ptxtFile and ctxtFile in date order as soon as every earlier day is done,
+ * so the merged files match a sequential run. No new day starts after a
+ * failure.
+ *
+ * @param[in] cs CS session, shared by all days
+ * @param[in] ta TA session, shared by all days
+ * @param[in] options Pipeline inputs and outputs
+ * @param[in] dates Dates to run
+ * @param[in] workers Days processed concurrently
+ * @param[in,out] seconds Runtime per step summed over the days, added to
+ * @return Number of days completed in order before the first failure
+ */
+int64_t RunDays(FHESession& cs, FHESession& ta, const PipelineOptions& options, const std::vector<std::string>& dates, int workers, std::map<std::string, double>& seconds) {
+
+    int64_t count = dates.size();
+    std::vector<int> status(count, 0);
+    std::vector<bool> finished(count, false);
+    std::vector<std::map<std::string, double>> daySeconds(count);
+    std::atomic<int64_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex dayMutex;
+    std::condition_variable dayDone;
+
+    auto dayOptions = [&options](const std::string& date) {
+        PipelineOptions day = options;
+        day.resultDir = options.resultDir + "/" + date;
+        day.ptxtFile = options.ptxtFile + "." + date;
+        day.ctxtFile = options.ctxtFile + "." + date;
+        return day;
+    };
+
+    std::vector<std::thread> pool;
+    for (int w = 0; w < std::max(1, workers); w++) {
+        pool.emplace_back([&]() {
+            for (int64_t i = next++; i < count && !failed; i = next++) {
+                PipelineOptions day = dayOptions(dates[i]);
+                if (!Store().InMemory() || Store().Persist()) {
+                    mkdir(day.resultDir.c_str(), 0755);
+                }
+                int result = RunDay(cs, ta, day, dates[i], i, daySeconds[i]);
+                std::lock_guard<std::mutex> lock(dayMutex);
+                status[i] = result;
+                finished[i] = true;
+                failed = failed || result != 0;
+                dayDone.notify_all();
+            }
+        });
+    }
+
+    // Merge in date order while later days are still running. Days are
+    // handed out in order, so every day before a failed one does finish.
+    int64_t merged = 0;
+    for (; merged < count; merged++) {
+        {
+            std::unique_lock<std::mutex> lock(dayMutex);
+            dayDone.wait(lock, [&]() { return finished[merged]; });
+        }
+        if (status[merged] != 0) {
+            break;
+        }
+        PipelineOptions day = dayOptions(dates[merged]);
+        for (const auto& file : {std::make_pair(day.ptxtFile, options.ptxtFile), std::make_pair(day.ctxtFile, options.ctxtFile)}) {
+            std::ifstream part(file.first);
+            std::ofstream whole(file.second, std::ios::app);
+            whole << part.rdbuf();
+            part.close();
+            std::remove(file.first.c_str());
+        }
+        for (const auto& step : daySeconds[merged]) {
+            seconds[step.first] += step.second;
+        }
+    }
+
+    for (std::thread& worker : pool) {
+        worker.join();
+    }
+    return merged;
+
+}
+
+#endif // SMART_PIPELINE_HPP
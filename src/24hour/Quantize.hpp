@@ -0,0 +1,246 @@
+/**
+ * @file Quantize.hpp
+ * @brief Fixed-point log and reciprocal log of meter readings (AVX2 or scalar)
+**/
+
+#ifndef SMART_QUANTIZE_HPP
+#define SMART_QUANTIZE_HPP
+
+#include <math.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SMART_QUANTIZE_X86 1
+#include <immintrin.h>
+#endif
+
+#define PRECISION 32        // pow(2, 5)
+#define PRECISION2 1024     // pow(2, 10)
+
+/**
+ * Distance from a rounding boundary (k + 0.5) below which the fast kernels
+ * hand a reading to QuantizeReading.
+ *
+ * The fast log evaluates log(m) = 2 atanh(s), s = (m - 1) / (m + 1), with
+ * m in [sqrt(1/2), sqrt(2)) and the series cut after s^13. Then
+ * |s| <= 0.1716 and the cut-off terms sum to at most
+ * 2 |s|^15 / (15 (1 - s^2)) < 5e-13; rounding adds a few ulp. For readings
+ * >= 0, log(x + 2) >= log 2, so the error is below 32 * 1e-12 on the log
+ * value and below 1024 / log(2)^2 * 1e-12 < 2.2e-9 on the reciprocal.
+ * A value that lands further than QUANTIZE_MARGIN from k + 0.5 therefore
+ * rounds the same way as with std::log. Only those two boundaries matter;
+ * the rounding is half up, so crossing an integer does not change it.
+ */
+#define QUANTIZE_MARGIN 1e-7
+
+/**
+ * @brief Fixed-point log and reciprocal log of one reading, rounded half up.
+ *
+ * @param[in] usage Meter reading
+ * @param[out] logValue PRECISION * log(usage + 2)
+ * @param[out] recLogValue PRECISION2 / log(usage + 2)
+ */
+inline void QuantizeReading(double usage, int64_t& logValue, int64_t& recLogValue) {
+
+    int64_t temp = PRECISION * log(usage + 2);
+    double tep = PRECISION * log(usage + 2);
+    int64_t temp_rec = PRECISION2 * 1 / log(usage + 2);
+    double tep_rec = PRECISION2 * 1 / log(usage + 2);
+
+    if (abs(tep - temp) >= 0.5) {
+        temp += 1;
+    }
+    if (abs(tep_rec - temp_rec) >= 0.5) {
+        temp_rec += 1;
+    }
+
+    logValue = temp;
+    recLogValue = temp_rec;
+
+}
+
+/**
+ * @brief Quantizes n readings.
+ */
+typedef void (*QuantizeFn)(const double* x, int64_t n, int64_t* logValues, int64_t* recLogValues);
+
+/**
+ * @brief QuantizeReading over a range, the reference for the other kernels.
+ *
+ * @param[in] x Readings
+ * @param[in] n Number of readings
+ * @param[out] logValues PRECISION * log(x + 2), rounded
+ * @param[out] recLogValues PRECISION2 / log(x + 2), rounded
+ */
+inline void QuantizeScalar(const double* x, int64_t n, int64_t* logValues, int64_t* recLogValues) {
+
+    for (int64_t i = 0; i < n; i++) {
+        QuantizeReading(x[i], logValues[i], recLogValues[i]);
+    }
+
+}
+
+#ifdef SMART_QUANTIZE_X86
+
+/**
+ * @brief log(x) for x >= 2, see QUANTIZE_MARGIN for the error bound.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256d FastLogAVX2(__m256d x) {
+
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d sqrt2 = _mm256_set1_pd(1.4142135623730951);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0); // 2^52
+
+    // x = m * 2^e with m in [1, 2), moved to [sqrt(1/2), sqrt(2))
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256i exponent = _mm256_srli_epi64(bits, 52);
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(exponent, _mm256_castpd_si256(magic))), magic);
+    e = _mm256_sub_pd(e, _mm256_set1_pd(1023.0));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000fffffffffffffLL)),
+        _mm256_castpd_si256(one)));
+    __m256d high = _mm256_cmp_pd(m, sqrt2, _CMP_GE_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), high);
+    e = _mm256_add_pd(e, _mm256_and_pd(high, one));
+
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    __m256d s2 = _mm256_mul_pd(s, s);
+    __m256d p = _mm256_set1_pd(1.0 / 13);
+    p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / 11));
+    p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / 9));
+    p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / 7));
+    p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / 5));
+    p = _mm256_fmadd_pd(p, s2, _mm256_set1_pd(1.0 / 3));
+    p = _mm256_fmadd_pd(p, s2, one);
+    __m256d logm = _mm256_mul_pd(_mm256_add_pd(s, s), p);
+    return _mm256_fmadd_pd(e, _mm256_set1_pd(0.6931471805599453), logm);
+
+}
+
+/**
+ * @brief Rounds v half up and flags lanes within QUANTIZE_MARGIN of k + 0.5.
+ */
+__attribute__((target("avx2,fma")))
+inline __m256i RoundHalfUpAVX2(__m256d v, __m256d& unsure) {
+
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d magic = _mm256_set1_pd(4503599627370496.0); // 2^52
+    __m256d whole = _mm256_floor_pd(v);
+    __m256d frac = _mm256_sub_pd(v, whole);
+    __m256d distance = _mm256_andnot_pd(_mm256_set1_pd(-0.0), _mm256_sub_pd(frac, half));
+    unsure = _mm256_or_pd(unsure, _mm256_cmp_pd(distance, _mm256_set1_pd(QUANTIZE_MARGIN), _CMP_LT_OQ));
+    whole = _mm256_add_pd(whole, _mm256_and_pd(_mm256_cmp_pd(frac, half, _CMP_GE_OQ), _mm256_set1_pd(1.0)));
+    // Exact for 0 <= whole < 2^52
+    return _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(whole, magic)), _mm256_castpd_si256(magic));
+
+}
+
+/**
+ * @brief QuantizeScalar, four readings per step with a polynomial log.
+ * Readings outside [0, 1e300] and lanes near a rounding boundary go through
+ * QuantizeReading, so the results are identical.
+ */
+__attribute__((target("avx2,fma")))
+inline void QuantizeAVX2(const double* x, int64_t n, int64_t* logValues, int64_t* recLogValues) {
+
+    const __m256d two = _mm256_set1_pd(2.0);
+    int64_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        __m256d inRange = _mm256_and_pd(_mm256_cmp_pd(v, _mm256_setzero_pd(), _CMP_GE_OQ),
+            _mm256_cmp_pd(v, _mm256_set1_pd(1e300), _CMP_LE_OQ));
+        __m256d l = FastLogAVX2(_mm256_add_pd(v, two));
+        __m256d unsure = _mm256_xor_pd(inRange, _mm256_castsi256_pd(_mm256_set1_epi64x(-1)));
+
+        __m256i logs = RoundHalfUpAVX2(_mm256_mul_pd(_mm256_set1_pd(PRECISION), l), unsure);
+        __m256i recLogs = RoundHalfUpAVX2(_mm256_div_pd(_mm256_set1_pd(PRECISION2), l), unsure);
+        _mm256_storeu_si256((__m256i*)(logValues + i), logs);
+        _mm256_storeu_si256((__m256i*)(recLogValues + i), recLogs);
+
+        int mask = _mm256_movemask_pd(unsure);
+        while (mask != 0) {
+            int lane = __builtin_ctz(mask);
+            QuantizeReading(x[i + lane], logValues[i + lane], recLogValues[i + lane]);
+            mask &= mask - 1;
+        }
+    }
+    QuantizeScalar(x + i, n - i, logValues + i, recLogValues + i);
+
+}
+
+#endif
+
+/**
+ * @brief Name of the default kernel, SG_QUANTIZE overrides the detection.
+ *
+ * @return "avx2" or "scalar"
+ */
+inline std::string QuantizeKernelName() {
+
+    const char* forced = std::getenv("SG_QUANTIZE");
+    if (forced) {
+        return forced;
+    }
+#ifdef SMART_QUANTIZE_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return "avx2";
+    }
+#endif
+    return "scalar";
+
+}
+
+/**
+ * @brief Kernel for a name. Unsupported names fall back to scalar.
+ *
+ * @param[in] name Kernel name
+ * @return Kernel
+ */
+inline QuantizeFn QuantizeKernel(const std::string& name) {
+
+#ifdef SMART_QUANTIZE_X86
+    if (name == "avx2" && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return QuantizeAVX2;
+    }
+#endif
+    return QuantizeScalar;
+
+}
+
+/**
+ * @brief Default kernel, the widest one the CPU supports.
+ *
+ * @return Kernel
+ */
+inline QuantizeFn BestQuantizeKernel() {
+
+    static const QuantizeFn best = QuantizeKernel(QuantizeKernelName());
+    return best;
+
+}
+
+/**
+ * @brief Quantizes the readings of one hour (or any run of readings) in one pass.
+ *
+ * @param[in] x Readings
+ * @param[in] n Number of readings
+ * @param[out] logValues PRECISION * log(x + 2), rounded, resized to n
+ * @param[out] recLogValues PRECISION2 / log(x + 2), rounded, resized to n
+ * @param[in] kernel Kernel, the widest supported one by default
+ */
+inline void QuantizeHour(const double* x, int64_t n, std::vector<int64_t>& logValues, std::vector<int64_t>& recLogValues, QuantizeFn kernel = nullptr) {
+
+    if (kernel == nullptr) {
+        kernel = BestQuantizeKernel();
+    }
+    logValues.resize(n);
+    recLogValues.resize(n);
+    kernel(x, n, logValues.data(), recLogValues.data());
+
+}
+
+#endif // SMART_QUANTIZE_HPP
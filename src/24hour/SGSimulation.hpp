@@ -24,7 +24,10 @@
 #include <cstddef>
 #include <iomanip>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <functional>
 #include <limits>
 #include <stdlib.h>
 #include <stdio.h>
@@ -40,10 +43,10 @@
 
 #include "omp.h"
 
-#define NF 16 // Number of threads
+// Thread count and scheduling are set at runtime, see Threads.hpp
 
-#define PRECISION 32        // pow(2, 5)
-#define PRECISION2 1024     // pow(2, 10)
+// PRECISION (pow(2, 5)) and PRECISION2 (pow(2, 10)) scale the log and 1/log readings
+#include "Quantize.hpp"
 
 #include "Utility.hpp"
 
@@ -0,0 +1,197 @@
+/**
+ * @file Session.hpp
+ * @brief FHE state shared by every step of one party (CS or TA)
+**/
+
+#ifndef SMART_SESSION_HPP
+#define SMART_SESSION_HPP
+
+#include "Manifest.hpp"
+#include "Threads.hpp"
+#include "TableStore.hpp"
+#include "ArtifactIO.hpp"
+#include "ArtifactStore.hpp"
+
+/**
+ * @brief LUT output table rows, either ciphertexts or NTT-form plaintexts.
+ */
+struct OutputTable {
+
+    std::unique_ptr<CipherTable> cipher;
+    std::unique_ptr<PlainTable> plain;
+
+    /**
+     * @brief Multiplies ct by row j. The plaintext path costs two NTTs and no
+     * relinearization; the ciphertext path leaves ct at size 3.
+     *
+     * @param[in] evaluator Evaluator
+     * @param[in,out] ct Ciphertext to multiply
+     * @param[in] j Table row
+     */
+    void MultiplyRow(seal::Evaluator& evaluator, seal::Ciphertext& ct, int64_t j) const {
+
+        if (cipher) {
+            evaluator.multiply_inplace(ct, (*cipher)[j]);
+        } else {
+            evaluator.transform_to_ntt_inplace(ct);
+            evaluator.multiply_plain_inplace(ct, (*plain)[j]);
+            evaluator.transform_from_ntt_inplace(ct);
+        }
+
+    }
+
+};
+
+/**
+ * @brief Holds the SEALContext, keys, cryptors and encrypted tables of one
+ * party so they are deserialized once instead of once per step.
+ */
+class FHESession {
+
+public:
+
+    /**
+     * @brief Loads the params and keys from Key/
+     *
+     * @param[in] loadGalois Load the GaloisKey (needed for rotations)
+     * @param[in] loadSecret Load the SecretKey and create a Decryptor
+     * @param[in] meterNum District size, selects Table/Manifest_<meterNum>
+     */
+    FHESession(bool loadGalois, bool loadSecret, int64_t meterNum = METER_NUM)
+        : context(CreateContextFromParams(PARAMS_FILEPATH, seal::scheme_type::bfv)),
+          publicKey(LoadKey<seal::PublicKey>(context, PUBLIC_KEY_FILEPATH)),
+          relinKey(LoadKey<seal::RelinKeys>(context, RELIN_KEY_FILEPATH)),
+          galoisKey(loadGalois ? LoadKey<seal::GaloisKeys>(context, GALOIS_KEY_FILEPATH) : seal::GaloisKeys()),
+          secretKey(loadSecret ? LoadKey<seal::SecretKey>(context, SECRET_KEY_FILEPATH) : seal::SecretKey()),
+          encryptor(context, publicKey),
+          evaluator(context),
+          batchEncoder(context) {
+
+        if (loadSecret) {
+            decryptor = std::make_unique<seal::Decryptor>(context, secretKey);
+            encryptor.set_secret_key(secretKey);
+        }
+        slotCount = batchEncoder.slot_count();
+        rowSize = slotCount / 2;
+        manifest = LoadManifest(meterNum, rowSize);
+
+        // The TA encrypts with the SecretKey unless --public-queries is set
+        bool publicEncryption = !loadSecret || !Artifacts().seededQueries;
+        if (publicEncryption && (Zeros().capacity > 0 || !Zeros().file.empty())) {
+            zeroPool = std::make_unique<ZeroPool>(context, publicKey, Zeros().capacity, Zeros().threads);
+            if (!Zeros().file.empty()) {
+                std::cout << "Zero pool: " << zeroPool->Load(Zeros().file) << " zeros loaded from " << Zeros().file << std::endl;
+            }
+        }
+
+    }
+
+    ~FHESession() {
+
+        if (zeroPool && !Zeros().file.empty()) {
+            std::cout << "Zero pool: " << zeroPool->Save(Zeros().file) << " zeros saved to " << Zeros().file << std::endl;
+        }
+
+    }
+
+    /**
+     * @brief Encrypts with the PublicKey, taking a precomputed zero from the
+     * pool when the process has one.
+     *
+     * @param[in] plain Encoded plaintext
+     * @param[out] destination Encryption of plain
+     */
+    void Encrypt(const seal::Plaintext& plain, seal::Ciphertext& destination) {
+
+        if (zeroPool) {
+            zeroPool->Encrypt(plain, destination);
+        } else {
+            encryptor.encrypt(plain, destination);
+        }
+
+    }
+
+    /**
+     * @brief Returns the Decryptor, only present when the SecretKey was loaded.
+     *
+     * @return Decryptor of the session
+     */
+    seal::Decryptor& Decryptor() {
+
+        if (!decryptor) {
+            throw std::logic_error("Session was created without the SecretKey");
+        }
+        return *decryptor;
+
+    }
+
+    /**
+     * @brief Returns an encrypted table, mapping it from Table/ on first use.
+     * Rows are deserialized when a step first reads them.
+     *
+     * @param[in] name Table name without the meter suffix, e.g. "AM_input"
+     * @param[in] rows Number of ciphertext rows in the table
+     * @return Cached table rows
+     */
+    const CipherTable& Table(const std::string& name, int64_t rows) {
+
+        std::lock_guard<std::mutex> lock(tableMutex);
+        std::unique_ptr<CipherTable>& table = tables[name];
+        if (!table) {
+            table = std::make_unique<CipherTable>(context, TablePath(name), rows);
+        }
+        return *table;
+
+    }
+
+    /**
+     * @brief Returns a LUT output table in the format the manifest records
+     *
+     * @param[in] name Table name without the meter suffix, e.g. "AM_output"
+     * @param[in] rows Number of rows in the table
+     * @return Cached table rows
+     */
+    const OutputTable& Output(const std::string& name, int64_t rows) {
+
+        std::lock_guard<std::mutex> lock(tableMutex);
+        OutputTable& table = outputs[name];
+        if (!table.cipher && !table.plain) {
+            if (manifest.plainOutputs) {
+                table.plain = std::make_unique<PlainTable>(context, TablePath(name), rows);
+            } else {
+                table.cipher = std::make_unique<CipherTable>(context, TablePath(name), rows);
+            }
+        }
+        return table;
+
+    }
+
+    seal::SEALContext context;
+    seal::PublicKey publicKey;
+    seal::RelinKeys relinKey;
+    seal::GaloisKeys galoisKey;
+    seal::SecretKey secretKey;
+    seal::Encryptor encryptor;
+    seal::Evaluator evaluator;
+    seal::BatchEncoder batchEncoder;
+    std::unique_ptr<seal::Decryptor> decryptor;
+    std::unique_ptr<ZeroPool> zeroPool;
+    size_t slotCount;
+    size_t rowSize;
+    TableManifest manifest;
+
+private:
+
+    std::string TablePath(const std::string& name) const {
+
+        return "Table/" + name + "_" + std::to_string(manifest.meterNum);
+
+    }
+
+    std::mutex tableMutex;
+    std::map<std::string, std::unique_ptr<CipherTable>> tables;
+    std::map<std::string, OutputTable> outputs;
+
+};
+
+#endif // SMART_SESSION_HPP
@@ -0,0 +1,37 @@
+#include "TASteps.hpp"
+#include "Daemon.hpp"
+
+int main(int argc, char** argv) {
+
+    // Keys stay resident; each job only pays for its own work
+
+    std::string socketPath = (argc > 1 && argv[1][0] != '-') ? argv[1] : "ta.sock";
+
+    std::cout << "Setting FHE" << std::endl;
+
+    std::vector<std::string> args(argv, argv + argc);
+    ConfigureThreads(args);
+    ConfigureArtifacts(args);
+    if (!Artifacts().seededQueries) {
+        // Only public-key queries take zeros from the pool
+        ConfigureZeroPool(args);
+    }
+    FHESession session(false, true, MeterCount(args));
+
+    return ServeJobs(socketPath, [&session](const std::vector<std::string>& args) {
+        if (args[0] == "Step2_TA1" && args.size() >= 2) {
+            return Step2TA1(session, args[1], HasFlag(args, "--batch"), HasFlag(args, "--stream"));
+        }
+        if (args[0] == "Step4_TA2" && args.size() == 3) {
+            return Step4TA2(session, args[1], args[2]);
+        }
+        if (args[0] == "Step6_TA3" && args.size() == 3) {
+            return Step6TA3(session, args[1], args[2]);
+        }
+        if (args[0] == "CheckRes" && args.size() == 4) {
+            return CheckRes(session, args[1], args[2], args[3]);
+        }
+        throw std::invalid_argument("Unknown TA job: " + args[0]);
+    });
+
+}
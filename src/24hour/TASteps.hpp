@@ -0,0 +1,634 @@
+/**
+ * @file TASteps.hpp
+ * @brief Trusted authority (TA) steps of the 24 hour pipeline
+**/
+
+#ifndef SMART_TA_STEPS_HPP
+#define SMART_TA_STEPS_HPP
+
+#include "Session.hpp"
+#include "IndexSearch.hpp"
+#include "HourQueue.hpp"
+
+/**
+ * @brief Input entries of a LUT: consecutive integers from first to last.
+ * first == last means unknown (no manifest), which disables row pruning.
+ */
+struct TableRange {
+
+    int64_t first = 0;
+    int64_t last = 0;
+
+};
+
+/**
+ * @brief Thrown when a ciphertext from CS has no noise budget left.
+ */
+struct NoiseBudgetError : std::runtime_error {
+
+    explicit NoiseBudgetError(const std::string& artifact)
+        : std::runtime_error(artifact + ": no noise budget left, rerun the CS step with --no-mod-switch") {}
+
+};
+
+/**
+ * @brief Checks that ct still decrypts correctly. CS switches the
+ * decryption-bound artifacts to the last level before saving them, so the
+ * TA checks what it decrypts here, whichever process saved it. All rows of
+ * an artifact go through the same operations, so one check per artifact
+ * stands for the others; --verify checks every row.
+ *
+ * @param[in] decryptor Decryptor of the TA session
+ * @param[in] ct Ciphertext from CS
+ * @return The noise budget is not exhausted
+ */
+bool HasNoiseBudget(seal::Decryptor& decryptor, const seal::Ciphertext& ct) {
+
+    return decryptor.invariant_noise_budget(ct) > 0;
+
+}
+
+/**
+ * @brief Decrypts LUT differences (daily value minus input entry) row by row
+ * and finds the entry closest to zero.
+ *
+ * Row 0 is decrypted first. Its slot 0 plus the first input entry gives the
+ * daily value, which names the one row that can hold the crossing, so the
+ * other rows are never decrypted. When the range is unknown or that row has
+ * no match, the remaining rows are decrypted in parallel waves of one row per
+ * thread, stopping at the first wave with a match. Each thread decrypts into
+ * its own Plaintext and slot buffer, reused across rows and calls. Row 0
+ * (with --verify every decrypted row) is checked for noise budget;
+ * NoiseBudgetError is thrown if it has none left.
+ *
+ * @param[in] session TA session (SecretKey)
+ * @param[in] rows Encrypted differences, one ciphertext per table row
+ * @param[in] direction Direction of the sign change
+ * @param[in] zeroHit An exact zero is a match by itself
+ * @param[in] range Input entries of the table
+ * @return Selected row and column
+ */
+SlotIndex DecryptAndFind(FHESession& session, const std::vector<seal::Ciphertext>& rows, Crossing direction, bool zeroHit, TableRange range) {
+
+    int64_t row_size = session.rowSize;
+    int64_t count = rows.size();
+
+    seal::Decryptor& decryptor = session.Decryptor();
+    bool verify = Artifacts().verifyBudget;
+    std::atomic<bool> exhausted{false};
+    auto search = [&session, &decryptor, &rows, &exhausted, verify, row_size, direction, zeroHit](int64_t i, int64_t* first_slot) {
+        static thread_local seal::Plaintext plain;
+        static thread_local std::vector<int64_t> slots;
+        if ((i == 0 || verify) && !HasNoiseBudget(decryptor, rows[i])) {
+            exhausted = true;
+            return (int64_t)-1;
+        }
+        decryptor.decrypt(rows[i], plain);
+        session.batchEncoder.decode(plain, slots);
+        if (first_slot) {
+            *first_slot = slots[0];
+        }
+        return FindInRow(slots, row_size, direction, zeroHit);
+    };
+
+    SlotIndex index;
+    if (count == 0) {
+        return index;
+    }
+
+    int64_t first_slot = 0;
+    int64_t col = search(0, &first_slot);
+    if (exhausted) {
+        throw NoiseBudgetError("LUT differences");
+    }
+    if (col >= 0) {
+        index.row = 0;
+        index.col = col;
+        index.found = true;
+        return index;
+    }
+
+    // Rows left to decrypt, the row the daily value falls into first
+    std::vector<int64_t> order;
+    int64_t candidate = -1;
+    if (range.first != range.last) {
+        int64_t step = (range.last > range.first) ? 1 : -1;
+        int64_t entry = first_slot * step; // (value - first) * step, value = first_slot + first
+        int64_t entries = (range.last - range.first) * step + 1;
+        if (entry >= 0 && entry < entries && entry / row_size < count) {
+            candidate = entry / row_size;
+        }
+    }
+    if (candidate > 0) {
+        order.push_back(candidate);
+    }
+    for (int64_t i = 1; i < count; i++) {
+        if (i != candidate) {
+            order.push_back(i);
+        }
+    }
+
+    int64_t wave = (candidate > 0) ? 1 : std::max(1, Threads().threads);
+    for (size_t begin = 0; begin < order.size() && !index.found; begin += wave) {
+        size_t end = std::min(order.size(), begin + wave);
+        std::vector<int64_t> cols(end - begin, -1);
+
+        ParallelLoop("decrypt");
+        #pragma omp parallel for schedule(runtime)
+        for (int64_t k = 0; k < (int64_t)(end - begin); k++) {
+            cols[k] = search(order[begin + k], nullptr);
+        }
+        if (exhausted) {
+            throw NoiseBudgetError("LUT differences");
+        }
+
+        for (size_t k = 0; k < cols.size(); k++) {
+            if (cols[k] >= 0) {
+                index.row = order[begin + k];
+                index.col = cols[k];
+                index.found = true;
+                break;
+            }
+        }
+        // The candidate missed: fall back to full waves
+        wave = std::max(1, Threads().threads);
+    }
+    return index;
+
+}
+
+/**
+ * @brief Decrypts the hourly AM/HM table differences and writes one PIR
+ * query per hour.
+ *
+ * With batch set, the selections of all 24 hours are written as one
+ * pir_AMHM_batch query of max(AM rows, HM rows) ciphertexts instead.
+ *
+ * @param[in] session TA session (PublicKey, SecretKey)
+ * @param[in] resultDir Directory for AM_i, HM_i and pir_AMHM_i
+ * @param[in] batch Write the batched query
+ * @param[in] stream Wait for each hour in AMHM.ready and announce each query
+ * in pir.ready, so Step1_CS1 and Step3_CS2 overlap with this step. Implies
+ * per-hour queries.
+ * @return Exit status
+ */
+int Step2TA1(FHESession& session, const std::string& resultDir, bool batch = false, bool stream = false) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& encryptor = session.encryptor;
+    auto& batchEncoder = session.batchEncoder;
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << row_size << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t row_count_fun1 = session.manifest.rowsAM;
+    int64_t row_count_fun2 = session.manifest.rowsHM;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    std::vector<seal::Ciphertext> ct_result1(row_count_fun1), ct_result2(row_count_fun2);
+    TableRange range1 = {session.manifest.amInputFirst, session.manifest.amInputLast};
+    TableRange range2 = {session.manifest.hmInputFirst, session.manifest.hmInputLast};
+
+    // Batched query: query j counts, per slot, the hours selecting that entry
+    // of table row j, AM in batch row 0 and HM in batch row 1
+
+    int64_t batch_rows = std::max(row_count_fun1, row_count_fun2);
+    std::vector<std::vector<int64_t>> query_batch(batch_rows, std::vector<int64_t>(slot_count, 0));
+    Store().Remove(resultDir + "/pir_AMHM_batch");
+    batch = batch && !stream;
+    HourQueue amhm_ready(resultDir + "/AMHM.ready");
+    HourQueue pir_ready(resultDir + "/pir.ready");
+
+    std::cout << "===Main===" << std::endl;
+
+    for (int64_t iter = 0; iter < 24; iter++) {
+        if (stream && amhm_ready.Next() != iter) {
+            std::cout << "AMHM.ready aborted or out of order at hour " << iter << std::endl;
+            pir_ready.Abort();
+            return 1;
+        }
+
+        ArtifactInput result_1, result_2;
+        result_1.open(resultDir + "/AM_" + std::to_string(iter));
+        result_2.open(resultDir + "/HM_" + std::to_string(iter));
+        seal::Ciphertext temp1, temp2;
+
+        for (int i = 0; i < row_count_fun1; i++) {
+            temp1.load(context, result_1);
+            ct_result1[i] = temp1;
+        }
+        for (int i = 0; i < row_count_fun2; i++) {
+            temp2.load(context, result_2);
+            ct_result2[i] = temp2;
+        }
+
+        result_1.close();
+        result_2.close();
+
+        ///////////////////////////////////////////////////////////////////
+
+        std::cout << "===Making PIR-query===" << std::flush;
+        std::cout << "Search index of function 1" << std::endl;
+
+        SlotIndex index_x = DecryptAndFind(session, ct_result1, Crossing::Falling, false, range1);
+        int64_t index_row_x = index_x.row, index_col_x = index_x.col;
+
+        std::cout << "Got index of function 1" << std::endl;
+        if (!index_x.found) {
+            std::cout << "ERROR: NO FIND 1" << std::endl;
+        }
+        std::cout << "Search index of function 2" << std::endl;
+        SlotIndex index_y = DecryptAndFind(session, ct_result2, Crossing::Rising, true, range2);
+        int64_t index_row_y = index_y.row, index_col_y = index_y.col;
+
+        std::cout << "Got index of function 2" << std::endl;
+        if (!index_y.found) {
+            std::cout << "ERROR: NO FIND 2" << std::endl;
+        }
+        if (!index_x.found || !index_y.found) {
+            // The default index would select LUT entry 0 and give a wrong ratio
+            std::cout << "No LUT entry for hour " << iter << ", no query written" << std::endl;
+            if (stream) {
+                pir_ready.Abort();
+            }
+            return 1;
+        }
+        std::cout << "Hour." << std::endl;
+        std::cout << "index_row_AM: " << index_row_x << ", index_col_AM: " << index_col_x << ", index_row_HM: " << index_row_y << ", index_col_HM: " << index_col_y << std::endl;
+        std::cout << "OK" << std::endl;
+
+        if (batch) {
+            query_batch[index_row_x][index_col_x]++;
+            query_batch[index_row_y][row_size + index_col_y]++;
+            continue;
+        }
+
+        std::vector<int64_t> query_AM0, query_AM1, query_HM0, query_HM1;
+        for (int64_t i = 0; i < row_size; i++) {
+            query_AM0.push_back((i == index_col_x) ? 1 : 0);
+            query_HM0.push_back((i == index_col_y) ? 1 : 0);
+        }
+        query_AM1 = ShiftWork(query_AM0, index_row_x, row_size);
+        query_AM0.resize(slot_count);
+        query_AM1.resize(slot_count);
+
+        query_HM1 = ShiftWork(query_HM0, index_row_y, row_size);
+        query_HM0.resize(slot_count);
+        query_HM1.resize(slot_count);
+
+        std::cout << "Making PIR-query > OK" << std::endl;
+
+        // Encrypt new query
+
+        std::cout << "===Encrypting===" << std::endl;
+
+        seal::Plaintext pt_query_AM0, pt_query_AM1, pt_query_HM0, pt_query_HM1;
+
+        batchEncoder.encode(query_AM0, pt_query_AM0);
+        batchEncoder.encode(query_AM1, pt_query_AM1);
+        batchEncoder.encode(query_HM0, pt_query_HM0);
+        batchEncoder.encode(query_HM1, pt_query_HM1);
+
+        // Write results to file, encrypting each query as it is saved
+
+        ArtifactOutput queryFile;
+        queryFile.open(resultDir + "/pir_AMHM_" + std::to_string(iter));
+        save.Query(encryptor, pt_query_AM0, queryFile, "pir_AMHM", session.zeroPool.get());
+        save.Query(encryptor, pt_query_AM1, queryFile, "pir_AMHM", session.zeroPool.get());
+        save.Query(encryptor, pt_query_HM0, queryFile, "pir_AMHM", session.zeroPool.get());
+        save.Query(encryptor, pt_query_HM1, queryFile, "pir_AMHM", session.zeroPool.get());
+        queryFile.close();
+        if (stream) {
+            pir_ready.Publish(iter);
+        }
+
+        std::cout << "Encrypting > OK" << std::endl;
+
+        std::cout << "Save query Hour." << iter << " > OK" << std::endl;
+
+    }
+    if (stream) {
+        amhm_ready.Finish();
+    }
+
+    if (batch) {
+        std::cout << "===Saving batched query===" << std::endl;
+        ArtifactOutput queryFile;
+        queryFile.open(resultDir + "/pir_AMHM_batch");
+        for (int64_t j = 0; j < batch_rows; j++) {
+            seal::Plaintext pt_query;
+            batchEncoder.encode(query_batch[j], pt_query);
+            save.Query(encryptor, pt_query, queryFile, "pir_AMHM", session.zeroPool.get());
+        }
+        queryFile.close();
+        std::cout << "Saved " << batch_rows << " query ciphertexts instead of " << 4 * 24 << std::endl;
+    }
+
+    std::cout << "===End===" << std::endl;
+
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    save.Report("Step2_TA1");
+    if (session.zeroPool) {
+        session.zeroPool->Report("Step2_TA1");
+    }
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Decrypts the inv_SUM_AM/div_HM table differences and writes the
+ * daily PIR query.
+ *
+ * @param[in] session TA session (PublicKey, SecretKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] resultDir Directory for inv_SUM_AM, div_HM and pir_SUM_AM_DIV_HM
+ * @return Exit status
+ */
+int Step4TA2(FHESession& session, const std::string& date, const std::string& resultDir) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& encryptor = session.encryptor;
+    auto& batchEncoder = session.batchEncoder;
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << row_size << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t sum_row_count_AM = session.manifest.rowsAMInv;
+    int64_t div_row_count_HM = session.manifest.rowsDivHM;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    std::vector<seal::Ciphertext> ct_result1(sum_row_count_AM), ct_result2(div_row_count_HM);
+    TableRange range1 = {session.manifest.sumAMInputFirst, session.manifest.sumAMInputLast};
+    TableRange range2 = {session.manifest.divHMInputFirst, session.manifest.divHMInputLast};
+
+    std::cout << "===Main===" << std::endl;
+
+    ArtifactInput result_1;
+    result_1.open(resultDir + "/inv_SUM_AM_" + date);
+    for (int i = 0; i < sum_row_count_AM; i++) {
+        seal::Ciphertext t;
+        t.load(context, result_1);
+        ct_result1[i] = t;
+    }
+    result_1.close();
+
+    ArtifactInput result_2;
+    result_2.open(resultDir + "/div_HM_" + date);
+    for (int i = 0; i < div_row_count_HM; i++) {
+        seal::Ciphertext t;
+        t.load(context, result_2);
+        ct_result2[i] = t;
+    }
+    result_2.close();
+
+    std::cout << "===Making PIR-query" << std::endl;
+    std::cout << "Search index of function 1" << std::endl;
+
+    SlotIndex index_x = DecryptAndFind(session, ct_result1, Crossing::Falling, false, range1);
+    int64_t index_row_x = index_x.row, index_col_x = index_x.col;
+
+    std::cout << "Got index of function 1" << std::endl;
+    if (!index_x.found) {
+        std::cout << "ERROR: NO FIND 1" << std::endl;
+    }
+    std::cout << "index_row_x: " << index_row_x << ", index_col_x: " << index_col_x << std::endl;
+    std::cout << "Search index of function 2" << std::endl;
+
+    SlotIndex index_y = DecryptAndFind(session, ct_result2, Crossing::Falling, true, range2);
+    int64_t index_row_y = index_y.row, index_col_y = index_y.col;
+
+    std::cout << "Got index of function 2" << std::endl;
+    if (!index_y.found) {
+        std::cout << "ERROR: NO FIND 2" << std::endl;
+    }
+    if (!index_x.found || !index_y.found) {
+        return 1;
+    }
+    std::cout << "index_row_y: " << index_row_y << ", index_col_y: " << index_col_y << std::endl;
+
+    // new_index is new_query left_shift the value of index
+
+    std::vector<int64_t> query_AM0, query_AM1, query_HM0, query_HM1;
+    for (int64_t i = 0; i < row_size; i++) {
+        query_AM0.push_back((i == index_col_x) ? 1 : 0);
+    }
+    query_AM1 = ShiftWork(query_AM0, index_row_x, row_size);
+    query_AM0.resize(slot_count);
+    query_AM1.resize(slot_count);
+
+    for (int64_t i = 0; i < row_size; i++) {
+        query_HM0.push_back((i == index_col_y) ? 1 : 0);
+    }
+    query_HM1 = ShiftWork(query_HM0, index_row_y, row_size);
+    query_HM0.resize(slot_count);
+    query_HM1.resize(slot_count);
+
+    std::cout << "Making PIR-query > OK" << std::endl;
+
+    // Encrypt new query
+
+    std::cout << "===Encrypting===" << std::endl;
+
+    seal::Plaintext pt_query_AM0, pt_query_AM1, pt_query_HM0, pt_query_HM1;
+
+    batchEncoder.encode(query_AM0, pt_query_AM0);
+    batchEncoder.encode(query_AM1, pt_query_AM1);
+    batchEncoder.encode(query_HM0, pt_query_HM0);
+    batchEncoder.encode(query_HM1, pt_query_HM1);
+
+    // Write to file, encrypting each query as it is saved
+
+    ArtifactOutput queryFile;
+    queryFile.open(resultDir + "/pir_SUM_AM_DIV_HM_" + date);
+    save.Query(encryptor, pt_query_AM0, queryFile, "pir_SUM_AM_DIV_HM", session.zeroPool.get());
+    save.Query(encryptor, pt_query_AM1, queryFile, "pir_SUM_AM_DIV_HM", session.zeroPool.get());
+    save.Query(encryptor, pt_query_HM0, queryFile, "pir_SUM_AM_DIV_HM", session.zeroPool.get());
+    save.Query(encryptor, pt_query_HM1, queryFile, "pir_SUM_AM_DIV_HM", session.zeroPool.get());
+    queryFile.close();
+
+    std::cout << "Encrypting > OK" << std::endl;
+
+    std::cout << "===End===" << std::endl;
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    save.Report("Step4_TA2");
+    if (session.zeroPool) {
+        session.zeroPool->Report("Step4_TA2");
+    }
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Decrypts the inv_100 table difference and writes the inv PIR query.
+ *
+ * @param[in] session TA session (PublicKey, SecretKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] resultDir Directory for inv_100 and pir_inv
+ * @return Exit status
+ */
+int Step6TA3(FHESession& session, const std::string& date, const std::string& resultDir) {
+
+    auto startWhole = std::chrono::high_resolution_clock::now();
+
+    auto& context = session.context;
+    auto& encryptor = session.encryptor;
+    auto& batchEncoder = session.batchEncoder;
+    ArtifactWriter save(session.context, session.evaluator);
+
+    size_t slot_count = session.slotCount;
+    size_t row_size = session.rowSize;
+
+    std::cout << "Plaintext matrix row size: " << row_size << std::endl;
+    std::cout << "Slot nums = " << slot_count << std::endl;
+
+    int64_t inv100_row = session.manifest.rows100Inv;
+
+    //////////////////////////////////////////////////////////////////////////////
+
+    std::vector<seal::Ciphertext> ct_result(inv100_row);
+    TableRange range = {session.manifest.inv100InputFirst, session.manifest.inv100InputLast};
+
+    std::cout << "===Main===" << std::endl;
+
+    ArtifactInput result_1;
+    result_1.open(resultDir + "/inv_100_" + date);
+    seal::Ciphertext temp1;
+    for (int i = 0; i < inv100_row; i++) {
+        temp1.load(context, result_1);
+        ct_result[i] = temp1;
+    }
+    result_1.close();
+
+    std::cout << "===Making PIR-query===" << std::endl;
+    std::cout << "Search index of function 1" << std::endl;
+
+    SlotIndex index_x = DecryptAndFind(session, ct_result, Crossing::Falling, false, range);
+    int64_t index_row_x = index_x.row, index_col_x = index_x.col;
+
+    std::cout << "Got index of function inv" << std::endl;
+    if (!index_x.found) {
+        std::cout << "ERROR: NO FIND" << std::endl;
+        return 1;
+    }
+
+    std::cout << "index_row_x: " << index_row_x << ", index_col_x: " << index_col_x << std::endl;
+    std::cout << "OK" << std::endl;
+
+    std::vector<int64_t> query_AM0, query_AM1;
+    for (int64_t i = 0; i < row_size; i++) {
+        query_AM0.push_back((i == index_col_x) ? 1 : 0);
+    }
+    query_AM1 = ShiftWork(query_AM0, index_row_x, row_size);
+    query_AM0.resize(slot_count);
+    query_AM1.resize(slot_count);
+    std::cout << "Making PIR-query > OK" << std::endl;
+
+    std::cout << "===Encrypting===" << std::endl;
+
+    seal::Plaintext pt_query_AM0, pt_query_AM1;
+    batchEncoder.encode(query_AM0, pt_query_AM0);
+    batchEncoder.encode(query_AM1, pt_query_AM1);
+
+    ArtifactOutput queryFile;
+    queryFile.open(resultDir + "/pir_inv_" + date);
+    save.Query(encryptor, pt_query_AM0, queryFile, "pir_inv", session.zeroPool.get());
+    save.Query(encryptor, pt_query_AM1, queryFile, "pir_inv", session.zeroPool.get());
+    queryFile.close();
+
+    std::cout << "Encrypting > OK" << std::endl;
+
+    std::cout << "===End===" << std::endl;
+
+    auto endWhole = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double> diffWhole = endWhole - startWhole;
+    std::cout << "Whole runtime is: " << diffWhole.count() << "s" << std::endl;
+    save.Report("Step6_TA3");
+    if (session.zeroPool) {
+        session.zeroPool->Report("Step6_TA3");
+    }
+    ShowMemoryUsage(getpid());
+
+    return 0;
+
+}
+
+/**
+ * @brief Decrypts finalRes and appends the ratio to the result file.
+ *
+ * @param[in] session TA session (SecretKey)
+ * @param[in] date Date of the data, used in result names
+ * @param[in] dirName Directory holding finalRes
+ * @param[in] saveFile Ciphertext ratio file, appended to
+ * @return Exit status
+ */
+int CheckRes(FHESession& session, const std::string& date, const std::string& dirName, const std::string& saveFile) {
+
+    auto& context = session.context;
+    auto& decryptor = session.Decryptor();
+    auto& batchEncoder = session.batchEncoder;
+
+    std::cout << "Plaintext matrix row size: " << session.rowSize << std::endl;
+    std::cout << "Slot nums = " << session.slotCount << std::endl;
+
+    // Get poly results situated
+
+    seal::Plaintext polyDecResultOne;
+    seal::Ciphertext tempOne;
+    std::vector<int64_t> decResultOne;
+    double tempResOne = 0.0;
+
+    // Load funOne into tempOne
+
+    ArtifactInput readFunOne(dirName + "/finalRes_" + date);
+    tempOne.load(context, readFunOne);
+    readFunOne.close();
+
+    std::cout << "part1 size after relinearization: " << tempOne.size() << std::endl;
+
+    // Decrypt and Decode
+
+    if (!HasNoiseBudget(decryptor, tempOne)) {
+        throw NoiseBudgetError("finalRes_" + date);
+    }
+    decryptor.decrypt(tempOne, polyDecResultOne);
+    batchEncoder.decode(polyDecResultOne, decResultOne);
+
+    // Output results
+
+    std::cout << "Dec: " << decResultOne[0] << std::endl << std::endl;
+    tempResOne = decResultOne[0] * 10000 / std::pow(2, 30);
+    std::cout << "Final Result: " << tempResOne << std::endl;
+    std::ofstream ctRatio;
+    ctRatio.open(saveFile, std::ios::app);
+    ctRatio << tempResOne << std::endl;
+    ctRatio.close();
+
+    std::cout << "Stop" << std::endl;
+
+    return 0;
+
+}
+
+#endif // SMART_TA_STEPS_HPP
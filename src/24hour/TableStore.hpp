@@ -0,0 +1,140 @@
+/**
+ * @file TableStore.hpp
+ * @brief Memory-mapped LUT tables, rows deserialized on first access
+**/
+
+#ifndef SMART_TABLESTORE_HPP
+#define SMART_TABLESTORE_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+/**
+ * @brief Table file written by MakeEncTab (one SEAL object per row), mapped
+ * read-only. Opening a table only walks the 16-byte SEAL headers to build the
+ * row offsets; a row is deserialized the first time it is used. The mapping
+ * is shared, so every process reading the same table uses one page-cache copy.
+ *
+ * @tparam T seal::Ciphertext or seal::Plaintext
+ */
+template <class T>
+class MappedTable {
+
+public:
+
+    /**
+     * @brief Maps a table file and indexes its rows
+     *
+     * @param[in] context SEALContext the rows are loaded with
+     * @param[in] path Table file
+     * @param[in] rows Number of rows in the table
+     */
+    MappedTable(const seal::SEALContext& context, const std::string& path, int64_t rows)
+        : context(context), path(path), offsets(rows + 1, 0), loaded(new std::once_flag[rows]), values(rows) {
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        struct stat info;
+        fstat(fd, &info);
+        length = info.st_size;
+        if (length > 0) {
+            void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapped == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error("Cannot map " + path);
+            }
+            base = static_cast<const seal::seal_byte*>(mapped);
+        }
+        close(fd);
+
+        for (int64_t i = 0; i < rows; i++) {
+            seal::Serialization::SEALHeader header;
+            if (offsets[i] + sizeof(header) > length) {
+                Unmap();
+                throw std::runtime_error(path + " holds fewer than " + std::to_string(rows) + " rows");
+            }
+            std::memcpy(&header, base + offsets[i], sizeof(header));
+            if (!seal::Serialization::IsValidHeader(header) || offsets[i] + header.size > length) {
+                Unmap();
+                throw std::runtime_error(path + ": invalid row " + std::to_string(i));
+            }
+            offsets[i + 1] = offsets[i] + header.size;
+        }
+
+    }
+
+    MappedTable(const MappedTable&) = delete;
+    MappedTable& operator=(const MappedTable&) = delete;
+
+    ~MappedTable() {
+
+        Unmap();
+
+    }
+
+    /**
+     * @brief Row j, deserialized from the mapping on first access. Safe to
+     * call from several threads.
+     *
+     * @param[in] j Table row
+     * @return Row
+     */
+    const T& operator[](int64_t j) const {
+
+        std::call_once(loaded[j], [&]() {
+            values[j].load(context, base + offsets[j], offsets[j + 1] - offsets[j]);
+        });
+        return values[j];
+
+    }
+
+    /**
+     * @brief Number of rows
+     */
+    int64_t size() const {
+
+        return values.size();
+
+    }
+
+    /**
+     * @brief Serialized size of the indexed rows in bytes
+     */
+    size_t bytes() const {
+
+        return offsets.back();
+
+    }
+
+private:
+
+    void Unmap() {
+
+        if (base != nullptr) {
+            munmap(const_cast<seal::seal_byte*>(base), length);
+            base = nullptr;
+        }
+
+    }
+
+    seal::SEALContext context;
+    std::string path;
+    const seal::seal_byte* base = nullptr;
+    size_t length = 0;
+    std::vector<size_t> offsets;
+    std::unique_ptr<std::once_flag[]> loaded;
+    mutable std::vector<T> values;
+
+};
+
+using CipherTable = MappedTable<seal::Ciphertext>;
+using PlainTable = MappedTable<seal::Plaintext>;
+
+#endif // SMART_TABLESTORE_HPP
@@ -0,0 +1,197 @@
+/**
+ * @file TableWriter.hpp
+ * @brief Parallel encoding and encryption of the LUT tables for MakeEncTab
+**/
+
+#ifndef SMART_TABLEWRITER_HPP
+#define SMART_TABLEWRITER_HPP
+
+#include "Threads.hpp"
+#include <deque>
+
+/**
+ * @brief Encrypts the rows of every queued table on a pool of threads and
+ * writes each table file in row order.
+ *
+ * Rows of all tables are dealt out round-robin, so independent tables are
+ * generated at the same time. Every worker owns its Encryptor, Evaluator and
+ * BatchEncoder. A finished row is serialized into the reorder buffer of its
+ * table, and the longest run of rows from the next unwritten one is appended
+ * to the file at once. Rows are only handed out in order, so a buffer holds
+ * fewer rows than there are workers.
+ */
+class TableWriter {
+
+public:
+
+    /**
+     * @param[in] context SEALContext
+     * @param[in] publicKey PublicKey
+     * @param[in] plainTables Keep output tables as NTT-form plaintexts (--plain)
+     * @param[in] threads Worker threads
+     */
+    TableWriter(const seal::SEALContext& context, const seal::PublicKey& publicKey, bool plainTables, int threads)
+        : context(context), publicKey(publicKey), plainTables(plainTables), threads(std::max(1, threads)) {
+
+        seal::BatchEncoder batchEncoder(context);
+        slotCount = batchEncoder.slot_count();
+        rowSize = slotCount / 2;
+
+    }
+
+    /**
+     * @brief Queues a LUT input table: every row is encrypted.
+     *
+     * @param[in] path Table file
+     * @param[in] values Table entries, rowSize per row
+     * @param[in] pad Entry filling the last row
+     */
+    void AddInput(const std::string& path, std::vector<int64_t> values, int64_t pad) {
+
+        Add(path, std::move(values), pad, false);
+
+    }
+
+    /**
+     * @brief Queues a LUT output table, saved by SaveOutputRow.
+     *
+     * @param[in] path Table file
+     * @param[in] values Table entries, rowSize per row
+     * @param[in] pad Entry filling the last row
+     */
+    void AddOutput(const std::string& path, std::vector<int64_t> values, int64_t pad) {
+
+        Add(path, std::move(values), pad, true);
+
+    }
+
+    /**
+     * @brief Writes every queued table, then prints rows, bytes and time per table.
+     */
+    void Run() {
+
+        for (Table& table : tables) {
+            table.file.open(table.path, std::ios::binary);
+            if (!table.file.is_open()) {
+                throw std::runtime_error("Cannot write " + table.path);
+            }
+        }
+
+        // Row 0 of every table, then row 1 of every table, and so on
+        std::vector<std::pair<size_t, int64_t>> jobs;
+        int64_t maxRows = 0;
+        for (const Table& table : tables) {
+            maxRows = std::max(maxRows, table.rows);
+        }
+        for (int64_t r = 0; r < maxRows; r++) {
+            for (size_t t = 0; t < tables.size(); t++) {
+                if (r < tables[t].rows) {
+                    jobs.emplace_back(t, r);
+                }
+            }
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> pool;
+        for (int w = 0; w < threads; w++) {
+            pool.emplace_back([&]() {
+                seal::Encryptor encryptor(context, publicKey);
+                seal::Evaluator evaluator(context);
+                seal::BatchEncoder batchEncoder(context);
+                for (size_t j = next++; j < jobs.size(); j = next++) {
+                    Table& table = tables[jobs[j].first];
+                    int64_t s = jobs[j].second;
+
+                    std::vector<int64_t> row(slotCount, 0);
+                    for (int64_t k = 0; k < rowSize; k++) {
+                        int64_t e = s * rowSize + k;
+                        row[k] = (e < (int64_t)table.values.size()) ? table.values[e] : table.pad;
+                    }
+
+                    seal::Plaintext plain;
+                    batchEncoder.encode(row, plain);
+                    std::ostringstream bytes;
+                    if (table.output) {
+                        SaveOutputRow(plain, plainTables, encryptor, evaluator, context, bytes);
+                    } else {
+                        seal::Ciphertext encrypted;
+                        encryptor.encrypt(plain, encrypted);
+                        encrypted.save(bytes);
+                    }
+                    Commit(table, s, bytes.str());
+                }
+            });
+        }
+        for (std::thread& worker : pool) {
+            worker.join();
+        }
+        std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+
+        for (Table& table : tables) {
+            table.file.close();
+            std::cout << table.path << ": " << table.rows << " rows, " << table.bytes << " bytes" << std::endl;
+        }
+        std::cout << "Tables: " << tables.size() << ", rows: " << jobs.size() << ", threads: " << threads
+            << ", encryption runtime is: " << diff.count() << "s" << std::endl;
+
+    }
+
+private:
+
+    struct Table {
+
+        std::string path;
+        std::vector<int64_t> values;
+        int64_t pad = 0;
+        bool output = false;
+        int64_t rows = 0;
+
+        std::ofstream file;
+        std::mutex fileMutex;
+        std::map<int64_t, std::string> pending;
+        int64_t nextRow = 0;
+        int64_t bytes = 0;
+
+    };
+
+    void Add(const std::string& path, std::vector<int64_t> values, int64_t pad, bool output) {
+
+        tables.emplace_back();
+        Table& table = tables.back();
+        table.path = path;
+        table.rows = (values.size() + rowSize - 1) / rowSize;
+        table.values = std::move(values);
+        table.pad = pad;
+        table.output = output;
+
+    }
+
+    /**
+     * @brief Puts a row in the reorder buffer and writes every row that is
+     * now in sequence.
+     */
+    void Commit(Table& table, int64_t row, std::string&& bytes) {
+
+        std::lock_guard<std::mutex> lock(table.fileMutex);
+        table.pending.emplace(row, std::move(bytes));
+        for (auto ready = table.pending.find(table.nextRow); ready != table.pending.end(); ready = table.pending.find(table.nextRow)) {
+            table.file.write(ready->second.data(), ready->second.size());
+            table.bytes += ready->second.size();
+            table.pending.erase(ready);
+            table.nextRow++;
+        }
+
+    }
+
+    seal::SEALContext context;
+    seal::PublicKey publicKey;
+    bool plainTables;
+    int threads;
+    size_t slotCount;
+    int64_t rowSize;
+    std::deque<Table> tables;
+
+};
+
+#endif // SMART_TABLEWRITER_HPP
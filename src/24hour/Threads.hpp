@@ -0,0 +1,216 @@
+/**
+ * @file Threads.hpp
+ * @brief Runtime OpenMP thread count, per-loop scheduling and CPU pinning
+**/
+
+#ifndef SMART_THREADS_HPP
+#define SMART_THREADS_HPP
+
+#include "SGSimulation.hpp"
+#if defined(__linux__)
+#include <sched.h>
+#include <dirent.h>
+#endif
+
+/**
+ * @brief OpenMP schedule of one loop.
+ */
+struct LoopSchedule {
+
+    omp_sched_t kind = omp_sched_static;
+    int chunk = 0;
+
+};
+
+/**
+ * @brief Process-wide thread settings.
+ *
+ * Command line: --threads N, --schedule [loop=]static|dynamic|guided[:chunk],...
+ * and --pin none|compact|spread. SG_THREADS, SG_SCHEDULE and SG_PIN are
+ * used when the flag is absent. Loops are "sum", "lut", "pir" and "decrypt".
+ */
+struct ThreadConfig {
+
+    int threads = omp_get_num_procs();
+    std::string pin = "none";
+    LoopSchedule defaultSchedule;
+    std::map<std::string, LoopSchedule> loopSchedules;
+
+};
+
+/**
+ * @brief Returns the process-wide thread settings.
+ *
+ * @return Thread settings
+ */
+ThreadConfig& Threads() {
+
+    static ThreadConfig config;
+    return config;
+
+}
+
+/**
+ * @brief Parses one schedule, e.g. "dynamic:2".
+ *
+ * @param[in] spec Schedule kind with an optional chunk size
+ * @return Parsed schedule
+ */
+LoopSchedule ParseSchedule(const std::string& spec) {
+
+    LoopSchedule schedule;
+    size_t colon = spec.find(':');
+    std::string kind = spec.substr(0, colon);
+
+    if (kind == "static") {
+        schedule.kind = omp_sched_static;
+    } else if (kind == "dynamic") {
+        schedule.kind = omp_sched_dynamic;
+    } else if (kind == "guided") {
+        schedule.kind = omp_sched_guided;
+    } else {
+        throw std::invalid_argument("Unknown schedule: " + spec);
+    }
+    if (colon != std::string::npos) {
+        schedule.chunk = std::stoi(spec.substr(colon + 1));
+    }
+    return schedule;
+
+}
+
+/**
+ * @brief CPUs grouped by NUMA node, from /sys. One group when unavailable.
+ *
+ * @return CPU ids per node
+ */
+std::vector<std::vector<int>> NumaNodeCpus() {
+
+    std::vector<std::vector<int>> nodes;
+#if defined(__linux__)
+    for (int node = 0; ; node++) {
+        std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpuList.is_open()) {
+            break;
+        }
+        std::vector<int> cpus;
+        std::string range;
+        while (std::getline(cpuList, range, ',')) {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = (dash == std::string::npos) ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        }
+        nodes.push_back(cpus);
+    }
+#endif
+    if (nodes.empty()) {
+        std::vector<int> cpus(omp_get_num_procs());
+        std::iota(cpus.begin(), cpus.end(), 0);
+        nodes.push_back(cpus);
+    }
+    return nodes;
+
+}
+
+/**
+ * @brief Pins every OpenMP worker to one CPU. "compact" fills a NUMA node
+ * before moving to the next one, "spread" deals threads across nodes.
+ *
+ * @param[in] pin Pinning policy
+ * @param[in] threads Team size to pin
+ */
+void PinThreads(const std::string& pin, int threads) {
+
+#if defined(__linux__)
+    if (pin == "none") {
+        return;
+    }
+
+    std::vector<std::vector<int>> nodes = NumaNodeCpus();
+    std::vector<int> order;
+    if (pin == "compact") {
+        for (const std::vector<int>& cpus : nodes) {
+            order.insert(order.end(), cpus.begin(), cpus.end());
+        }
+    } else if (pin == "spread") {
+        for (size_t i = 0; order.size() < (size_t)omp_get_num_procs(); i++) {
+            bool added = false;
+            for (const std::vector<int>& cpus : nodes) {
+                if (i < cpus.size()) {
+                    order.push_back(cpus[i]);
+                    added = true;
+                }
+            }
+            if (!added) {
+                break;
+            }
+        }
+    } else {
+        throw std::invalid_argument("Unknown pinning: " + pin);
+    }
+
+    omp_set_num_threads(threads);
+    #pragma omp parallel
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(order[omp_get_thread_num() % order.size()], &set);
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+#endif
+
+}
+
+/**
+ * @brief Reads the thread settings from the command line and environment,
+ * then pins the worker threads. Call once at startup.
+ *
+ * @param[in] args Command line arguments
+ */
+void ConfigureThreads(const std::vector<std::string>& args) {
+
+    auto setting = [&args](const std::string& flag, const char* env, const std::string& fallback) {
+        const char* value = std::getenv(env);
+        return GetOption(args, flag, value ? value : fallback);
+    };
+
+    ThreadConfig& config = Threads();
+    config.threads = std::stoi(setting("--threads", "SG_THREADS", std::to_string(omp_get_num_procs())));
+    config.pin = setting("--pin", "SG_PIN", "none");
+
+    std::stringstream schedules(setting("--schedule", "SG_SCHEDULE", "static"));
+    std::string entry;
+    while (std::getline(schedules, entry, ',')) {
+        size_t equals = entry.find('=');
+        if (equals == std::string::npos) {
+            config.defaultSchedule = ParseSchedule(entry);
+        } else {
+            config.loopSchedules[entry.substr(0, equals)] = ParseSchedule(entry.substr(equals + 1));
+        }
+    }
+
+    PinThreads(config.pin, config.threads);
+    std::cout << "Threads: " << config.threads << ", pinning: " << config.pin << std::endl;
+
+}
+
+/**
+ * @brief Applies the thread count and schedule of a loop to the next
+ * "#pragma omp parallel for schedule(runtime)".
+ *
+ * @param[in] loop Loop name
+ */
+void ParallelLoop(const std::string& loop) {
+
+    const ThreadConfig& config = Threads();
+    auto found = config.loopSchedules.find(loop);
+    const LoopSchedule& schedule = (found != config.loopSchedules.end()) ? found->second : config.defaultSchedule;
+
+    omp_set_num_threads(config.threads);
+    omp_set_schedule(schedule.kind, schedule.chunk);
+
+}
+
+#endif // SMART_THREADS_HPP
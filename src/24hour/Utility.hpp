@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <seal/seal.h>
+#include "ConsumptionData.hpp"
 
 #if defined(unix) || defined(__unix__) || defined(__unix)
 /**
@@ -274,57 +275,66 @@ seal::SEALContext CreateContextFromParams(std::string filepath, seal::scheme_typ
 }
 
 /**
- * @brief Makes a map from files.
- * 
- * @param[in] filename Path to data file.
- * @return Newly created map of files with hour data for each day.
+ * @brief Checks whether an optional flag was passed on the command line.
+ *
+ * @param[in] args Command line arguments
+ * @param[in] flag Flag to look for, e.g. "--packed"
+ * @return True if the flag is present
  */
-std::map<std::string, std::vector<double>> ReadData(const std::string& filename) {
-
-    // Read power consumption as map
-
-    std::ifstream readData(filename);
-    std::map<std::string, std::vector<double>> hourData;
-    std::string usage_str, line_str, time_st;
-    std::vector<double> usage_hour;
-
-    bool flag = true;
-    // Read each row as a new stringstream
-    while (std::getline(readData, line_str)) {
-        std::stringstream ss(line_str);
-        // Divide as two parts: A string and a new stringstream
-        while (std::getline(ss, usage_str, ',')) {
-            if (flag) {
-                time_st = usage_str;
-                flag = false;
-            } else {
-                double temp = std::stod(usage_str);
-                usage_hour.push_back(temp);
-            }
+bool HasFlag(const std::vector<std::string>& args, const std::string& flag) {
+
+    for (const std::string& arg : args) {
+        if (arg == flag) {
+            return true;
         }
+    }
+    return false;
 
-        // Here if you don't need the first row which is the meters' number
-        if (time_st != "TimeSlot") {
-            hourData.insert(std::pair<std::string, std::vector<double>>(time_st, usage_hour));
+}
+
+/**
+ * @brief Returns the value following an optional command line flag.
+ *
+ * @param[in] args Command line arguments
+ * @param[in] flag Flag to look for, e.g. "--spool"
+ * @param[in] fallback Value used when the flag is absent
+ * @return Value of the flag
+ */
+std::string GetOption(const std::vector<std::string>& args, const std::string& flag, const std::string& fallback) {
+
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] == flag) {
+            return args[i + 1];
         }
-        usage_hour.clear();
-        flag = true;
     }
+    return fallback;
+
+}
+
+/**
+ * @brief Path of one meter's ciphertexts for one hour in a spool directory.
+ *
+ * @param[in] spoolDir Spool directory written by MeterFleet
+ * @param[in] hour Hour of the day
+ * @param[in] meter Meter index in the daily file
+ * @return File path
+ */
+std::string SpoolPath(const std::string& spoolDir, int64_t hour, int64_t meter) {
 
-    return hourData;
+    return spoolDir + "/" + std::to_string(hour) + "_" + std::to_string(meter);
 
 }
 
 /**
  * @brief Calculates the harmonic mean for the datda from 1 hour.
  * 
- * @param x Hour data
+ * @param x Hour data, one reading per meter
+ * @param N Number of meters
  * @return Harmonic mean for that hour
  */
-double HarmonicMean(std::vector<double> x) {
+double HarmonicMean(const double* x, int64_t N) {
 
     double sum_hm_double = 0.0, temp;
-    int64_t N = x.size();
     for (int64_t i = 0; i < N; ++i) {
         temp = 1 / log(x[i] + 2); // Scale 100 times
         sum_hm_double += temp;
@@ -333,10 +343,9 @@ double HarmonicMean(std::vector<double> x) {
 
 }
 
-double ArithmeticMean(std::vector<double> x) {
+double ArithmeticMean(const double* x, int64_t N) {
 
     double sum_am_double = 0.0, temp;
-    int64_t N = x.size();
     for (int64_t i = 0; i < N; ++i) {
         temp = log(x[i] + 2); // Scale x times
         sum_am_double += temp;
@@ -345,4 +354,119 @@ double ArithmeticMean(std::vector<double> x) {
 
 }
 
+/**
+ * @brief Saves one encoded LUT output row, encrypted with the PublicKey or,
+ * for tables the CS keeps in the clear, as an NTT-form plaintext ready for
+ * multiply_plain.
+ *
+ * @param[in,out] plain Encoded row, transformed to NTT form when plainTable
+ * @param[in] plainTable Save the plaintext instead of a ciphertext
+ * @param[in] encryptor Encryptor
+ * @param[in] evaluator Evaluator
+ * @param[in] context SEALContext
+ * @param[in] file Table file
+ */
+void SaveOutputRow(seal::Plaintext& plain, bool plainTable, seal::Encryptor& encryptor, seal::Evaluator& evaluator, const seal::SEALContext& context, std::ostream& file) {
+
+    if (plainTable) {
+        evaluator.transform_to_ntt_inplace(plain, context.first_parms_id());
+        plain.save(file);
+    } else {
+        seal::Ciphertext encrypted;
+        encryptor.encrypt(plain, encrypted);
+        encrypted.save(file);
+    }
+
+}
+
+/**
+ * @brief Rotate-and-sum over each batch row: afterwards every slot of a row
+ * holds the row total. Takes log2(rowSize) rotations and keeps one extra
+ * ciphertext alive, instead of rowSize - 1 rotations held at once.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in,out] ct Ciphertext to sum
+ * @param[in] rowSize Slots in one batch row (a power of two)
+ * @param[in] galoisKey GaloisKeys with the power-of-two steps
+ */
+void TotalSum(seal::Evaluator& evaluator, seal::Ciphertext& ct, size_t rowSize, const seal::GaloisKeys& galoisKey) {
+
+    seal::Ciphertext rotated;
+    for (size_t step = 1; step < rowSize; step *= 2) {
+        evaluator.rotate_rows(ct, -(int)step, galoisKey, rotated);
+        evaluator.add_inplace(ct, rotated);
+    }
+
+}
+
+/**
+ * @brief TotalSum of independent ciphertexts, one per loop iteration, with
+ * the current OpenMP thread count and runtime schedule. Extra memory is one
+ * ciphertext per thread.
+ *
+ * @param[in] evaluator Evaluator
+ * @param[in,out] cts Ciphertexts to sum
+ * @param[in] rowSize Slots in one batch row (a power of two)
+ * @param[in] galoisKey GaloisKeys with the power-of-two steps
+ */
+void TotalSum(seal::Evaluator& evaluator, const std::vector<seal::Ciphertext*>& cts, size_t rowSize, const seal::GaloisKeys& galoisKey) {
+
+    #pragma omp parallel for schedule(runtime)
+    for (int64_t i = 0; i < (int64_t)cts.size(); i++) {
+        TotalSum(evaluator, *cts[i], rowSize, galoisKey);
+    }
+
+}
+
+/**
+ * @brief Relinearizes only ciphertexts that grew past two polynomials, i.e.
+ * after a real multiplication, and counts the calls it skipped.
+ */
+class Relinearizer {
+
+public:
+
+    /**
+     * @param[in] evaluator Evaluator used for the key switch
+     * @param[in] relinKey RelinKeys
+     */
+    Relinearizer(seal::Evaluator& evaluator, const seal::RelinKeys& relinKey)
+        : evaluator(evaluator), relinKey(relinKey) {}
+
+    /**
+     * @brief Relinearizes ct in place when its size is above 2.
+     *
+     * @param[in,out] ct Ciphertext
+     */
+    void operator()(seal::Ciphertext& ct) {
+
+        if (ct.size() > 2) {
+            evaluator.relinearize_inplace(ct, relinKey);
+            performed++;
+        } else {
+            elided++;
+        }
+
+    }
+
+    /**
+     * @brief Prints how many relinearizations ran and how many were skipped.
+     *
+     * @param[in] step Step name for the report
+     */
+    void Report(const std::string& step) const {
+
+        std::cout << step << " relinearize: " << performed << " performed, " << elided << " elided" << std::endl;
+
+    }
+
+private:
+
+    seal::Evaluator& evaluator;
+    const seal::RelinKeys& relinKey;
+    std::atomic<int64_t> performed{0};
+    std::atomic<int64_t> elided{0};
+
+};
+
 #endif // SMART_UTILITY_HPP
\ No newline at end of file
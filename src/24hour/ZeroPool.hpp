@@ -0,0 +1,305 @@
+/**
+ * @file ZeroPool.hpp
+ * @brief Precomputed public-key encryptions of zero, refilled in idle time
+**/
+
+#ifndef SMART_ZEROPOOL_HPP
+#define SMART_ZEROPOOL_HPP
+
+#include "SGSimulation.hpp"
+#include <deque>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief Process-wide pool settings.
+ *
+ * Command line: --zero-pool N keeps N encryptions of zero ready (0, the
+ * default, encrypts directly), --zero-pool-threads T sets the generator
+ * threads and --zero-pool-file FILE carries unused zeros from one process to
+ * the next. SG_ZERO_POOL, SG_ZERO_POOL_THREADS and SG_ZERO_POOL_FILE are used
+ * when the flag is absent. Only processes that call ConfigureZeroPool get a
+ * pool: the CS steps, and the TA steps with --public-queries. A TA session
+ * with seeded queries never creates one.
+ */
+struct ZeroPoolConfig {
+
+    int64_t capacity = 0;
+    int threads = 1;
+    std::string file;
+
+};
+
+/**
+ * @brief Returns the process-wide pool settings.
+ *
+ * @return Pool settings
+ */
+ZeroPoolConfig& Zeros() {
+
+    static ZeroPoolConfig config;
+    return config;
+
+}
+
+/**
+ * @brief Reads the pool settings from the command line and environment.
+ * Call once at startup, before the sessions are created.
+ *
+ * @param[in] args Command line arguments
+ */
+void ConfigureZeroPool(const std::vector<std::string>& args) {
+
+    ZeroPoolConfig& config = Zeros();
+    const char* capacity = std::getenv("SG_ZERO_POOL");
+    const char* threads = std::getenv("SG_ZERO_POOL_THREADS");
+    const char* file = std::getenv("SG_ZERO_POOL_FILE");
+
+    config.capacity = std::stoll(GetOption(args, "--zero-pool", capacity ? capacity : "0"));
+    config.threads = std::stoi(GetOption(args, "--zero-pool-threads", threads ? threads : "1"));
+    config.file = GetOption(args, "--zero-pool-file", file ? file : "");
+
+}
+
+/**
+ * @brief Encryption as an addition: a fresh public-key encryption of zero
+ * plus the encoded value. For BFV this is exactly what Encryptor::encrypt
+ * does, so the result has the same noise and its own randomness; the zero
+ * is only generated ahead of time.
+ *
+ * Generator threads keep the pool at its capacity. On Linux they run under
+ * SCHED_IDLE and only get CPUs the steps leave unused. Every zero is handed
+ * out once. When the pool is empty the zero is generated on the spot and
+ * counted as a miss.
+ */
+class ZeroPool {
+
+public:
+
+    /**
+     * @param[in] context SEALContext of the session
+     * @param[in] publicKey PublicKey of the session
+     * @param[in] capacity Zeros kept ready
+     * @param[in] generators Background generator threads
+     */
+    ZeroPool(const seal::SEALContext& context, const seal::PublicKey& publicKey, int64_t capacity, int generators)
+        : context(context), publicKey(publicKey), encryptor(context, publicKey), evaluator(context), capacity(capacity) {
+
+        for (int g = 0; g < std::max(1, generators); g++) {
+            workers.emplace_back([this]() { Generate(); });
+        }
+
+    }
+
+    ~ZeroPool() {
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            stop = true;
+        }
+        wanted.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+
+    }
+
+    /**
+     * @brief Encrypts plain with the PublicKey, as Encryptor::encrypt.
+     *
+     * @param[in] plain Encoded plaintext
+     * @param[out] destination Encryption of plain
+     */
+    void Encrypt(const seal::Plaintext& plain, seal::Ciphertext& destination) {
+
+        bool hit = false;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!zeros.empty()) {
+                destination = std::move(zeros.front());
+                zeros.pop_front();
+                hit = true;
+            }
+        }
+        if (hit) {
+            taken++;
+            wanted.notify_one();
+        } else {
+            misses++;
+            encryptor.encrypt_zero(destination);
+        }
+        evaluator.add_plain_inplace(destination, plain);
+
+    }
+
+    /**
+     * @brief Adds the zeros saved in a file and deletes the file, so that no
+     * zero can be used twice. The file stays locked from the first read to
+     * the unlink, so of two processes sharing the file only one gets them.
+     *
+     * @param[in] path Pool file
+     * @return Zeros loaded
+     */
+    int64_t Load(const std::string& path) {
+
+        int fd = LockPoolFile(path, O_RDONLY);
+        if (fd < 0) {
+            return 0;
+        }
+        std::string bytes;
+        char buffer[1 << 16];
+        for (ssize_t n = read(fd, buffer, sizeof(buffer)); n > 0; n = read(fd, buffer, sizeof(buffer))) {
+            bytes.append(buffer, n);
+        }
+        unlink(path.c_str());
+        close(fd);
+
+        std::vector<seal::Ciphertext> loaded;
+        std::istringstream in(bytes);
+        while (in.peek() != std::istringstream::traits_type::eof()) {
+            seal::Ciphertext zero;
+            zero.load(context, in);
+            loaded.push_back(std::move(zero));
+        }
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (seal::Ciphertext& zero : loaded) {
+            zeros.push_back(std::move(zero));
+        }
+        return loaded.size();
+
+    }
+
+    /**
+     * @brief Moves the unused zeros to the end of a file for a later process.
+     * Appends under the same lock as Load.
+     *
+     * @param[in] path Pool file, appended to
+     * @return Zeros saved
+     */
+    int64_t Save(const std::string& path) {
+
+        std::deque<seal::Ciphertext> unused;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            unused.swap(zeros);
+        }
+        if (unused.empty()) {
+            return 0;
+        }
+        std::ostringstream out;
+        for (const seal::Ciphertext& zero : unused) {
+            zero.save(out);
+        }
+        std::string bytes = out.str();
+
+        int fd = LockPoolFile(path, O_WRONLY | O_APPEND | O_CREAT);
+        if (fd < 0) {
+            return 0;
+        }
+        for (size_t done = 0; done < bytes.size();) {
+            ssize_t n = write(fd, bytes.data() + done, bytes.size() - done);
+            if (n <= 0) {
+                break;
+            }
+            done += n;
+        }
+        close(fd);
+        return unused.size();
+
+    }
+
+    /**
+     * @brief Prints the pool use since the last report.
+     *
+     * @param[in] step Step name for the report
+     */
+    void Report(const std::string& step) {
+
+        int64_t ready;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            ready = zeros.size();
+        }
+        std::cout << step << " zero pool: " << taken.exchange(0) << " taken, " << misses.exchange(0)
+            << " generated on demand, " << ready << "/" << capacity << " ready" << std::endl;
+
+    }
+
+private:
+
+    /**
+     * @brief Opens the pool file and takes an exclusive flock on it. A file
+     * that Load unlinked while this process waited for the lock is opened
+     * again, so the lock always belongs to the file at path.
+     *
+     * @return Locked descriptor, -1 if the file cannot be opened
+     */
+    static int LockPoolFile(const std::string& path, int flags) {
+
+        for (;;) {
+            int fd = open(path.c_str(), flags, 0600);
+            if (fd < 0) {
+                return -1;
+            }
+            struct stat locked, current;
+            if (flock(fd, LOCK_EX) == 0 && fstat(fd, &locked) == 0 && stat(path.c_str(), &current) == 0
+                && locked.st_ino == current.st_ino && locked.st_dev == current.st_dev) {
+                return fd;
+            }
+            close(fd);
+            if (!(flags & O_CREAT)) {
+                return -1;
+            }
+        }
+
+    }
+
+    void Generate() {
+
+#if defined(__linux__)
+        sched_param idle = {};
+        pthread_setschedparam(pthread_self(), SCHED_IDLE, &idle);
+#endif
+        seal::Encryptor generator(context, publicKey);
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(poolMutex);
+                wanted.wait(lock, [this]() { return stop || (int64_t)(zeros.size() + pending) < capacity; });
+                if (stop) {
+                    return;
+                }
+                pending++;
+            }
+            seal::Ciphertext zero;
+            generator.encrypt_zero(zero);
+            std::lock_guard<std::mutex> lock(poolMutex);
+            pending--;
+            zeros.push_back(std::move(zero));
+        }
+
+    }
+
+    seal::SEALContext context;
+    seal::PublicKey publicKey;
+    seal::Encryptor encryptor;
+    seal::Evaluator evaluator;
+    int64_t capacity;
+
+    std::mutex poolMutex;
+    std::condition_variable wanted;
+    std::deque<seal::Ciphertext> zeros;
+    int64_t pending = 0;
+    bool stop = false;
+    std::atomic<int64_t> taken{0};
+    std::atomic<int64_t> misses{0};
+    std::vector<std::thread> workers;
+
+};
+
+#endif // SMART_ZEROPOOL_HPP
@@ -3,6 +3,41 @@ import subprocess
 import datetime
 import time
 import shutil
+import socket
+import sys
+import concurrent.futures
+
+# With --daemon the steps are sent to bin/CSDaemon and bin/TADaemon, which
+# keep keys and tables loaded between days, instead of spawning bin/<Step>
+use_daemon = '--daemon' in sys.argv
+# With --batch Step2_TA1 sends all 24 hourly PIR queries as one batched query
+batch_flag = ' --batch' if '--batch' in sys.argv else ''
+# With --stream Step1_CS1, Step2_TA1 and Step3_CS2 overlap hour by hour
+use_stream = '--stream' in sys.argv
+# With --archive FILE Step1_CS1 reads each day from a ConvertArchive archive
+# instead of parsing its CSV file
+archive_flag = f" --archive {sys.argv[sys.argv.index('--archive') + 1]}" if '--archive' in sys.argv else ''
+
+def run_step(sock_path, cmd):
+    if not use_daemon:
+        return subprocess.getstatusoutput(f"bin/{cmd}")
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+        s.connect(sock_path)
+        s.sendall(f"{cmd}\n".encode())
+        reply = s.makefile().readline().strip()
+    return (0 if reply == '0' else 1, reply)
+
+# A failed --stream step leaves its consumer waiting for the next hour;
+# appending the abort marker (-1) to the queue file releases it
+def abort_queue(queue):
+    with open(f"Result/{queue}", mode='a') as out:
+        out.write("-1\n")
+
+def run_ta1_stream():
+    (status, output) = run_step('ta.sock', "Step2_TA1 Result --stream")
+    if status != 0:
+        abort_queue('pir.ready')
+    return (status, output)
 
 begin = datetime.date(2014, 1, 1) # Set the date of data here
 end = datetime.date(2014, 12, 30) # We did not use the data of 2/29
@@ -23,59 +58,83 @@ print("==============================\nsubprocess.getstatusoutput(bin/MakeEncTab
 (status, output) = subprocess.getstatusoutput('bin/MakeEncTab_1')
 print(status, output)
 
-i = 0
-start = time.process_time()
-
-while day <= end:
-    today = day.strftime("%Y-%m-%d")
-    #print(i, today)
-
-    out_res = open("ctxt_res/test2014.txt", mode='a')
-    out_res.write(f"{i},")
-    out_res.close()
-    out_resp = open("ptxt_res/test2014.txt", mode='a')
-    out_resp.write(f"{i},")
-    out_resp.close()
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step1_CS1)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step1_CS1 {path}{today}.txt ptxt_res/test2014.txt Result")
-    print(output)
-
-    exit(0)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step2_TA1)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step2_TA1 Result")
-    print(status, output)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step3_CS2)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step3_CS2 {today} Result")
-    print(status, output)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step4_TA2)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step4_TA2 {today} Result")
-    print(status, output)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step5_CS3)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step5_CS3 {today} Result")
-    print(status, output)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/Step6_TA3)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step6_TA3 {today} Result")
+# With --pipeline the whole date range runs in-process in bin/Pipeline, with
+# the artifacts kept in memory instead of Result/. --days N runs N days at once
+if '--pipeline' in sys.argv:
+    days_flag = f" --days {sys.argv[sys.argv.index('--days') + 1]}" if '--days' in sys.argv else ''
+    (status, output) = subprocess.getstatusoutput(f"bin/Pipeline {path} {begin} {end}{batch_flag}{days_flag}{archive_flag}")
     print(status, output)
+    exit(status)
 
-    print("==============================\nsubprocess.getstatusoutput(bin/Step7_CS4)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/Step7_CS4 {today} Result")
-    print(status, output)
-
-    print("==============================\nsubprocess.getstatusoutput(bin/CheckRes)\n==============================")
-    (status, output) = subprocess.getstatusoutput(f"bin/CheckRes {today} Result ctxt_res/test2014.txt")
-    print(status, output)
+i = 0
+start = time.process_time()
 
-    shutil.rmtree('Result')
-    os.mkdir('Result')
-    day += delta
-    i += 1
+# One worker runs Step2_TA1 next to Step1_CS1/Step3_CS2 under --stream
+with concurrent.futures.ThreadPoolExecutor(max_workers=1) as ta_executor:
+    while day <= end:
+        today = day.strftime("%Y-%m-%d")
+        #print(i, today)
+
+        out_res = open("ctxt_res/test2014.txt", mode='a')
+        out_res.write(f"{i},")
+        out_res.close()
+        out_resp = open("ptxt_res/test2014.txt", mode='a')
+        out_resp.write(f"{i},")
+        out_resp.close()
+
+        if use_stream:
+            # Step2_TA1 reads each AM_i/HM_i as Step1_CS1 finishes it, and
+            # Step3_CS2 reads each pir_AMHM_i as Step2_TA1 finishes it
+            ta_job = ta_executor.submit(run_ta1_stream)
+            (status, output) = run_step('cs.sock', f"Step1_CS1 {path}{today}.txt ptxt_res/test2014.txt Result --stream{archive_flag}")
+            print(status, output)
+            if status != 0:
+                abort_queue('AMHM.ready')
+            else:
+                (status, output) = run_step('cs.sock', f"Step3_CS2 {today} Result --stream")
+                print(status, output)
+            (ta_status, ta_output) = ta_job.result()
+            print(ta_status, ta_output)
+            if status != 0 or ta_status != 0:
+                print(f"Streamed steps failed on {today}")
+                exit(1)
+        else:
+            print("==============================\nsubprocess.getstatusoutput(bin/Step1_CS1)\n==============================")
+            (status, output) = run_step('cs.sock', f"Step1_CS1 {path}{today}.txt ptxt_res/test2014.txt Result{archive_flag}")
+            print(output)
+
+            print("==============================\nsubprocess.getstatusoutput(bin/Step2_TA1)\n==============================")
+            (status, output) = run_step('ta.sock', f"Step2_TA1 Result{batch_flag}")
+            print(status, output)
+
+            print("==============================\nsubprocess.getstatusoutput(bin/Step3_CS2)\n==============================")
+            (status, output) = run_step('cs.sock', f"Step3_CS2 {today} Result")
+            print(status, output)
+
+        print("==============================\nsubprocess.getstatusoutput(bin/Step4_TA2)\n==============================")
+        (status, output) = run_step('ta.sock', f"Step4_TA2 {today} Result")
+        print(status, output)
+
+        print("==============================\nsubprocess.getstatusoutput(bin/Step5_CS3)\n==============================")
+        (status, output) = run_step('cs.sock', f"Step5_CS3 {today} Result")
+        print(status, output)
+
+        print("==============================\nsubprocess.getstatusoutput(bin/Step6_TA3)\n==============================")
+        (status, output) = run_step('ta.sock', f"Step6_TA3 {today} Result")
+        print(status, output)
+
+        print("==============================\nsubprocess.getstatusoutput(bin/Step7_CS4)\n==============================")
+        (status, output) = run_step('cs.sock', f"Step7_CS4 {today} Result")
+        print(status, output)
+
+        print("==============================\nsubprocess.getstatusoutput(bin/CheckRes)\n==============================")
+        (status, output) = run_step('ta.sock', f"CheckRes {today} Result ctxt_res/test2014.txt")
+        print(status, output)
+
+        shutil.rmtree('Result')
+        os.mkdir('Result')
+        day += delta
+        i += 1
 
-    exit(0)
 end = time.process_time()
 print(end - start)
\ No newline at end of file